@@ -4,31 +4,106 @@
 #
 #-------------------------------------------------
 
-QT       += core sql
-
-QT       -= gui
+QT       += core sql gui network
 
 TARGET = WeatherStation
-CONFIG   += console
+CONFIG   += console c++11
 CONFIG   -= app_bundle
 
 TEMPLATE = app
 
+# Build the ingest server for a fleet of stations instead of the station
+# itself with: qmake CONFIG+=ingestserver
+ingestserver {
+
+QT       -= gui
+
+TARGET = WeatherIngestServer
 
-SOURCES += main.cpp \
+SOURCES += ingestmain.cpp \
     weatherdatabase.cpp \
-    dht22sensor.cpp \
-    bmp085.cpp \
-    weatherstation.cpp
+    retentionmanager.cpp \
+    ingestserver.cpp \
+    ingestsimulator.cpp
+
+HEADERS += \
+    weatherdatabase.h \
+    retentionmanager.h \
+    ingestprotocol.h \
+    ingestserver.h \
+    ingestsimulator.h
+
+} else {
+
+# Build the benchmark suite of the station instead of the station itself
+# with: qmake CONFIG+=benchmark
+benchmark {
+
+TARGET = WeatherStationBenchmark
+
+SOURCES += benchmarkmain.cpp \
+    benchmark.cpp
+
+HEADERS += \
+    benchmark.h \
+    sensorfixtures.h
+
+# Build the unit tests of the station instead of the station itself with:
+# qmake CONFIG+=test && make check
+} else:test {
+
+QT       += testlib
+
+TARGET = WeatherStationTest
+CONFIG   += testcase
+
+SOURCES += weatherstationtest.cpp
+
+HEADERS += sensorfixtures.h
+
+} else {
+
+SOURCES += main.cpp
 
 target.path = /home/pi
 INSTALLS += target
 
+}
+
+SOURCES += \
+    weatherdatabase.cpp \
+    dht22sensor.cpp \
+    bmp085.cpp \
+    weatherstation.cpp \
+    retentionmanager.cpp \
+    swingingdoor.cpp \
+    imagestore.cpp \
+    imagepipeline.cpp \
+    weatherpublisher.cpp \
+    httpserver.cpp \
+    slidingwindow.cpp \
+    streamanalytics.cpp \
+    bulkimporter.cpp \
+    columnexporter.cpp
+
 HEADERS += \
     weatherdatabase.h \
     dht22sensor.h \
     bmp085.h \
-    weatherstation.h
+    weatherstation.h \
+    retentionmanager.h \
+    swingingdoor.h \
+    imagestore.h \
+    imagepipeline.h \
+    weatherpublisher.h \
+    weathersharedmemory.h \
+    weatherreader.h \
+    httpserver.h \
+    ingestprotocol.h \
+    slidingwindow.h \
+    streamanalytics.h \
+    bulkimporter.h \
+    columnexporter.h
 
 unix:!macx: LIBS += -L$$PWD/../../../mnt/raspberry-rootfs/usr/local/lib/ -lbcm2835
 
@@ -43,3 +118,5 @@ INCLUDEPATH += $$PWD/../../../mnt/raspberry-rootfs/usr/local/include
 DEPENDPATH += $$PWD/../../../mnt/raspberry-rootfs/usr/local/include
 
 unix:!macx: LIBS += -lrt
+
+}
@@ -0,0 +1,339 @@
+/*
+ * Date:        19-10-2026
+ * Description: Minimal microbenchmark harness. Each benchmark measures the
+ *              time and the number of heap allocations per operation. The
+ *              results are written as JSON and can be compared against the
+ *              results of a previous (baseline) run to catch regressions.
+ *
+ *              Allocations are counted by wrapping the glibc allocator:
+ *              malloc, calloc, realloc and the aligned allocators. This
+ *              includes every variant of operator new, which libstdc++
+ *              builds on them, and the allocations of the Qt containers.
+ *              Without glibc, or when built static (define
+ *              BENCHMARK_NO_MALLOC_HOOKS), only the (non-aligned) operator
+ *              new and new[] are counted.
+ */
+
+#include "benchmark.h"
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QHash>
+#include <QDebug>
+#include <new>
+#include <stdlib.h>
+#include <errno.h>
+
+std::atomic<long> benchmark_allocations(0);
+
+#if defined(__GLIBC__) && !defined(BENCHMARK_NO_MALLOC_HOOKS)
+
+// The C allocator of glibc is wrapped. operator new (every variant) is built
+// on top of malloc() and aligned_alloc() by libstdc++, so it is counted too.
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+    void *__libc_valloc(size_t size);
+    void *__libc_pvalloc(size_t size);
+
+    void *malloc(size_t size)
+    {
+        benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(ptr, size);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void **ptr, size_t alignment, size_t size)
+    {
+        void *memory;
+
+        if(alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+        memory = __libc_memalign(alignment, size);
+
+        if(memory == NULL)
+            return ENOMEM;
+
+        *ptr = memory;
+        return 0;
+    }
+
+    void *valloc(size_t size)
+    {
+        benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_valloc(size);
+    }
+
+    void *pvalloc(size_t size)
+    {
+        benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_pvalloc(size);
+    }
+}
+
+#else
+
+// Without glibc, or in a static build, the C allocator cannot be wrapped.
+// Only operator new is counted then, allocations made with malloc() (e.g.
+// by the Qt containers) are missed.
+void *operator new(size_t size)
+{
+    void *memory;
+
+    benchmark_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    while((memory = malloc(size > 0 ? size : 1)) == NULL)
+    {
+        std::new_handler handler = std::get_new_handler();
+        if(handler == NULL)
+            throw std::bad_alloc();
+        handler();
+    }
+
+    return memory;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch(...)
+    {
+        return NULL;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    free(ptr);
+}
+
+#endif
+
+Benchmark::Benchmark(const QString &filter)
+/*
+ * Constructor.
+ *
+ * in:  filter Only run the benchmarks whose name contains the filter.
+ * out: none
+ */
+{
+    this->filter = filter;
+    this->failures = 0;
+}
+
+void Benchmark::AddMetric(const QString &name, const QString &metric, const QVariant &value)
+/*
+ * Attach an additional metric (e.g. a compression ratio) to a benchmark.
+ *
+ * in:  name   Name of the benchmark.
+ *      metric Name of the metric.
+ *      value  Value of the metric.
+ * out: none
+ */
+{
+    for(int i = 0; i < this->results.size(); i++)
+    {
+        if(this->results[i].name == name)
+        {
+            this->results[i].metrics.insert(metric, value);
+            return;
+        }
+    }
+}
+
+void Benchmark::Check(const QString &name, bool condition, const QString &message)
+/*
+ * Verify a result of a benchmark, a failed check fails the run.
+ *
+ * in:  name      Name of the benchmark.
+ *      condition Condition that must hold.
+ *      message   Description of the check.
+ * out: none
+ */
+{
+    if(!condition)
+    {
+        qWarning() << "FAILED" << name << ":" << message;
+        this->failures++;
+    }
+}
+
+bool Benchmark::Selected(const QString &name) const
+/*
+ * Whether a benchmark is selected by the filter.
+ */
+{
+    return this->filter.isEmpty() || name.contains(this->filter);
+}
+
+QJsonDocument Benchmark::ToJson() const
+/*
+ * Results of all benchmarks that were run.
+ *
+ * in:  none
+ * out: return {"benchmarks": [{"name", "iterations", "ns_per_op",
+ *             "allocs_per_op", "metrics"}, ...]}
+ */
+{
+    QJsonArray benchmarks;
+
+    foreach(const BenchmarkResult &result, this->results)
+    {
+        QJsonObject object;
+
+        object["name"] = result.name;
+        object["iterations"] = (double)result.iterations;
+        object["ns_per_op"] = result.ns_per_op;
+        object["allocs_per_op"] = result.allocs_per_op;
+        object["metrics"] = QJsonObject::fromVariantMap(result.metrics);
+
+        benchmarks.append(object);
+    }
+
+    QJsonObject root;
+    root["benchmarks"] = benchmarks;
+
+    return QJsonDocument(root);
+}
+
+int Benchmark::CompareBaseline(const QJsonDocument &baseline, double threshold) const
+/*
+ * Compare the results against a baseline run. A benchmark regresses when it
+ * is more than threshold percent slower, or makes more allocations per
+ * operation (beyond BENCHMARK_ALLOC_SLACK).
+ *
+ * in:  baseline  Results of the baseline run (see ToJson()).
+ *      threshold Allowed slowdown in percent.
+ * out: return    Number of regressions.
+ */
+{
+    QHash<QString, QJsonObject> reference;
+    int regressions = 0;
+
+    foreach(const QJsonValue &value, baseline.object()["benchmarks"].toArray())
+        reference.insert(value.toObject()["name"].toString(), value.toObject());
+
+    foreach(const BenchmarkResult &result, this->results)
+    {
+        if(!reference.contains(result.name))
+            continue;
+
+        double ns = reference[result.name]["ns_per_op"].toDouble();
+        double allocs = reference[result.name]["allocs_per_op"].toDouble();
+        double change = ns > 0 ? (result.ns_per_op - ns) * 100.0 / ns : 0.0;
+
+        if(change > threshold)
+        {
+            qWarning().nospace() << "REGRESSION " << result.name << ": " << result.ns_per_op
+                                 << " ns/op, baseline " << ns << " ns/op (+" << change << "%)";
+            regressions++;
+        }
+
+        if(result.allocs_per_op > allocs + BENCHMARK_ALLOC_SLACK)
+        {
+            qWarning().nospace() << "REGRESSION " << result.name << ": " << result.allocs_per_op
+                                 << " allocs/op, baseline " << allocs << " allocs/op";
+            regressions++;
+        }
+    }
+
+    return regressions;
+}
+
+int Benchmark::Failures() const
+/*
+ * Number of failed checks.
+ */
+{
+    return this->failures;
+}
+
+void Benchmark::AddResult(const QString &name, qint64 iterations, qint64 nsecs, long allocations)
+/*
+ * Store and print the result of a benchmark. Also used for operations that
+ * can only be measured once, e.g. an import, which are timed by the caller.
+ *
+ * in:  name        Name of the benchmark.
+ *      iterations  Number of operations.
+ *      nsecs       Time taken by all operations.
+ *      allocations Heap allocations made by all operations.
+ * out: none
+ */
+{
+    BenchmarkResult result;
+
+    result.name = name;
+    result.iterations = iterations;
+    result.ns_per_op = (double)nsecs / iterations;
+    result.allocs_per_op = (double)allocations / iterations;
+
+    this->results.append(result);
+
+    qDebug().nospace() << qPrintable(name.leftJustified(40)) << " " << result.ns_per_op << " ns/op, "
+                       << result.allocs_per_op << " allocs/op";
+}
@@ -0,0 +1,99 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/*
+ * Date:        19-10-2026
+ * Description: Minimal microbenchmark harness. Each benchmark measures the
+ *              time and the number of heap allocations per operation. The
+ *              results are written as JSON and can be compared against the
+ *              results of a previous (baseline) run to catch regressions.
+ */
+
+#include <QString>
+#include <QList>
+#include <QVariantMap>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <atomic>
+
+#define BENCHMARK_MIN_TIME      (200000000LL)   // nsec per measurement
+#define BENCHMARK_ALLOC_SLACK   (0.5)           // allocations per operation
+
+// Number of heap allocations made by the process, see benchmark.cpp for
+// what is counted.
+extern std::atomic<long> benchmark_allocations;
+
+struct BenchmarkResult
+{
+    QString name;
+    qint64 iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    QVariantMap metrics;
+};
+
+class Benchmark
+{
+public:
+    Benchmark(const QString &filter);
+
+    template<typename Operation>
+    void Run(const QString &name, Operation operation);
+
+    void AddResult(const QString &name, qint64 iterations, qint64 nsecs, long allocations);
+    void AddMetric(const QString &name, const QString &metric, const QVariant &value);
+    void Check(const QString &name, bool condition, const QString &message);
+    bool Selected(const QString &name) const;
+
+    QJsonDocument ToJson() const;
+    int CompareBaseline(const QJsonDocument &baseline, double threshold) const;
+    int Failures() const;
+
+private:
+    QString filter;
+    QList<BenchmarkResult> results;
+    int failures;
+};
+
+template<typename Operation>
+void Benchmark::Run(const QString &name, Operation operation)
+/*
+ * Measure an operation. The number of iterations is doubled until a
+ * measurement takes at least BENCHMARK_MIN_TIME, the last measurement is
+ * reported.
+ *
+ * in:  name      Name of the benchmark.
+ *      operation Callable performing a single operation, gets the
+ *                iteration number as argument.
+ * out: none
+ */
+{
+    QElapsedTimer timer;
+    qint64 iterations = 1;
+    qint64 nsecs = 0;
+    long allocations = 0;
+
+    if(!Selected(name))
+        return;
+
+    for(;;)
+    {
+        allocations = benchmark_allocations.load();
+        timer.start();
+
+        for(qint64 i = 0; i < iterations; i++)
+            operation(i);
+
+        nsecs = timer.nsecsElapsed();
+        allocations = benchmark_allocations.load() - allocations;
+
+        if(nsecs >= BENCHMARK_MIN_TIME)
+            break;
+
+        iterations *= 2;
+    }
+
+    AddResult(name, iterations, nsecs, allocations);
+}
+
+#endif // BENCHMARK_H
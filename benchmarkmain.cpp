@@ -0,0 +1,1245 @@
+/*
+ * Date:        19-10-2026
+ * Description: main function of the benchmark suite. Measures the sensor
+ *              decoding, compression, storage and publishing paths of the
+ *              weatherstation without the sensors attached, and verifies
+ *              their results.
+ *
+ *              WeatherStationBenchmark [--filter <name>] [--output <file>]
+ *                                      [--baseline <file>] [--threshold <%>]
+ *
+ *              The exit code is non-zero when a check fails or a benchmark
+ *              regressed compared to the baseline.
+ */
+
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QImage>
+#include <QBuffer>
+#include <QFile>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <benchmark.h>
+#include <dht22sensor.h>
+#include <bmp085.h>
+#include <swingingdoor.h>
+#include <weatherdatabase.h>
+#include <imagestore.h>
+#include <weatherpublisher.h>
+#include <weatherreader.h>
+#include <streamanalytics.h>
+#include <bulkimporter.h>
+#include <columnexporter.h>
+#include <QSaveFile>
+#include <QSqlQuery>
+#include <QThread>
+#include <QTcpSocket>
+#include <QEventLoop>
+#include <QTimer>
+#include <httpserver.h>
+#include <sensorfixtures.h>
+
+#define SERIES_LENGTH       (7 * 24 * 60)   // a week of samples at one per minute
+#define SAMPLE_INTERVAL     (60000)         // msec
+#define CONTENDED_READERS   (16)
+#define LATENCY_SAMPLES     (100000)
+#define HTTP_CONNECTIONS    (16)
+#define HTTP_SUBSCRIBERS    (256)
+#define HTTP_EVENTS         (100)           // readings pushed to the subscribers
+#define ANALYTICS_SENSORS   (64)
+#define ANALYTICS_WINDOWS   (16)
+#define IMPORT_ROWS         (200000)
+#define IMPORT_INVALID      (1000)          // every n-th row of the import is invalid
+#define EXPORT_ROWS         (200000)        // rows per quantity
+
+static void series(WeatherQuantity quantity, QVector<float> *values)
+/*
+ * A week of realistic samples: a daily cycle, weather changes and sensor
+ * noise, quantized to the resolution of the sensor.
+ */
+{
+    unsigned int seed = 42 + quantity;
+    double drift = 0;
+
+    values->resize(SERIES_LENGTH);
+
+    for(int i = 0; i < SERIES_LENGTH; i++)
+    {
+        double day = 2 * M_PI * i / (24 * 60);
+        double noise;
+
+        seed = seed * 1103515245 + 12345;
+        noise = ((seed >> 16) % 1000) / 1000.0 - 0.5;
+        drift += noise * 0.01;
+
+        switch(quantity)
+        {
+        case QUANTITY_TEMPERATURE:
+            (*values)[i] = roundf((12 + 6 * sin(day) + drift + noise * 0.1) * 10) / 10;
+            break;
+        case QUANTITY_HUMIDITY:
+            (*values)[i] = roundf((70 - 15 * sin(day) + drift * 5 + noise * 0.4) * 10) / 10;
+            break;
+        default:
+            (*values)[i] = roundf((1013 + 8 * sin(day / 3.5) + drift + noise * 0.04) * 100) / 100;
+            break;
+        }
+    }
+}
+
+static QByteArray jpeg_frame(int brightness, int object_x, unsigned int seed)
+/*
+ * A 320x240 camera-like frame: a gradient sky, an object and sensor noise.
+ */
+{
+    QImage image(320, 240, QImage::Format_RGB32);
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+
+    for(int y = 0; y < 240; y++)
+    {
+        QRgb *line = (QRgb *)image.scanLine(y);
+        for(int x = 0; x < 320; x++)
+        {
+            seed = seed * 1103515245 + 12345;
+            int v = qBound(0, brightness + y / 4 + (int)((seed >> 16) % 5) - 2
+                              + (abs(x - object_x) < 20 && y > 150 ? -60 : 0), 255);
+            line[x] = qRgb(v, v, qMin(255, v + 20));
+        }
+    }
+
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPG", 100);
+
+    return jpeg;
+}
+
+static void benchmark_sensors(Benchmark &bench)
+/*
+ * Sensor decoding: DHT22 pulse traces and BMP085 compensation.
+ */
+{
+    QVector<QLinkedList<long> > traces;
+    float temperature = 0, humidity = 0, pressure = 0;
+    bool ok = true;
+
+    for(int i = 0; i < 64; i++)
+    {
+        int data[5];
+        dht22_frame(-20 + i * 0.7f, 20 + i, data);
+        traces.append(dht22_trace(data, i));
+    }
+
+    for(int i = 0; i < traces.size(); i++)
+    {
+        ok &= DHT22Sensor::DecodePulses(traces[i], &temperature, &humidity);
+        ok &= fabsf(temperature - (-20 + i * 0.7f)) < 0.051f && fabsf(humidity - (20 + i)) < 0.051f;
+    }
+    bench.Check("dht22_decode", ok, "decoded traces match the encoded values");
+
+    bench.Run("dht22_decode", [&](qint64 i) {
+        DHT22Sensor::DecodePulses(traces[i % traces.size()], &temperature, &humidity);
+    });
+
+    BMP085 bmp085;
+    bmp085.load_calibration_data(bmp085_eeprom);
+    bmp085.set_mode(BMP085_ULTRALOWPOWER);
+    bmp085.compensate_pressure(BMP085_EXAMPLE_UT, BMP085_EXAMPLE_UP, &pressure);
+    bench.Check("bmp085_compensate", fabsf(pressure - 699.64f) < 0.005f, "datasheet example gives 699.64 hPa");
+
+    bench.Run("bmp085_compensate", [&](qint64 i) {
+        bmp085.compensate_pressure(BMP085_EXAMPLE_UT + (i & 255), BMP085_EXAMPLE_UP + (i & 1023), &pressure);
+    });
+}
+
+static void benchmark_swingingdoor(Benchmark &bench)
+/*
+ * Swinging door compression: cost per sample, reduction of the stored rows
+ * and verification of the error bound on a week of realistic data.
+ */
+{
+    const float tolerances[QUANTITY_COUNT] = { 0.1f, 0.3f, 0.05f };
+    const char *names[QUANTITY_COUNT] = { "temperature", "humidity", "airpressure" };
+
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+    {
+        QString name = QString("swingingdoor_%1").arg(names[q]);
+        QVector<float> values;
+        QVector<SwingingDoorSample> stored;
+        SwingingDoorSample sample, output[SWINGINGDOOR_MAX_OUTPUT];
+        double max_error = 0;
+
+        if(!bench.Selected(name))
+            continue;
+
+        series((WeatherQuantity)q, &values);
+
+        SwingingDoor door(tolerances[q], 900000);
+        for(int i = 0; i < values.size(); i++)
+        {
+            sample.time = (int64_t)i * SAMPLE_INTERVAL;
+            sample.value = values[i];
+            int count = door.AddSample(sample, output);
+            for(int j = 0; j < count; j++)
+                stored.append(output[j]);
+        }
+        int count = door.Flush(output);
+        for(int j = 0; j < count; j++)
+            stored.append(output[j]);
+
+        // Reconstruct by linear interpolation between the stored samples.
+        for(int i = 0, k = 0; i < values.size(); i++)
+        {
+            int64_t time = (int64_t)i * SAMPLE_INTERVAL;
+            while(k + 1 < stored.size() && stored[k + 1].time <= time)
+                k++;
+            double value = stored[k].value;
+            if(stored[k].time != time)
+                value += (stored[k + 1].value - stored[k].value) * (double)(time - stored[k].time)
+                         / (stored[k + 1].time - stored[k].time);
+            max_error = qMax(max_error, fabs(value - values[i]));
+        }
+
+        SwingingDoor timed(tolerances[q], 900000);
+        bench.Run(name, [&](qint64 i) {
+            SwingingDoorSample s, o[SWINGINGDOOR_MAX_OUTPUT];
+            s.time = i * SAMPLE_INTERVAL;
+            s.value = values[i % values.size()];
+            timed.AddSample(s, o);
+        });
+
+        // A stored row holds a DATETIME (5 bytes) and a FLOAT (4 bytes).
+        bench.AddMetric(name, "rows_in", values.size());
+        bench.AddMetric(name, "rows_out", stored.size());
+        bench.AddMetric(name, "bytes_in", values.size() * 9);
+        bench.AddMetric(name, "bytes_out", stored.size() * 9);
+        bench.AddMetric(name, "reduction", (double)values.size() / stored.size());
+        bench.AddMetric(name, "max_error", max_error);
+        bench.Check(name, max_error <= tolerances[q] + 1e-4, "reconstruction within the tolerance");
+    }
+}
+
+static double relative_error(double value, double reference)
+{
+    return fabs(value - reference) / qMax(1.0, fabs(reference));
+}
+
+static void benchmark_analytics(Benchmark &bench)
+/*
+ * Stream analytics: cost per sample, verification of every window against
+ * a brute force recomputation and of the alerts on a passing storm.
+ */
+{
+    QVector<float> values[QUANTITY_COUNT];
+
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+        series((WeatherQuantity)q, &values[q]);
+
+    if(bench.Selected("analytics_sample"))
+    {
+        StreamAnalytics analytics;
+        double max_error = 0;
+
+        for(int i = 0; i < SERIES_LENGTH; i++)
+        {
+            for(int q = 0; q < QUANTITY_COUNT; q++)
+                analytics.AddSample((WeatherQuantity)q, (int64_t)i * SAMPLE_INTERVAL, values[q][i]);
+
+            if(i % 7 != 0)
+                continue;
+
+            for(int q = 0; q < QUANTITY_COUNT; q++)
+            {
+                for(int w = 0; w < ANALYTICS_WINDOW_COUNT; w++)
+                {
+                    const SlidingWindow &window = analytics.Window((WeatherQuantity)q, w);
+                    int first = qMax(0, i - (int)(window.Length() / SAMPLE_INTERVAL));
+                    double n = i - first + 1, sx = 0, sy = 0, sxx = 0, sxy = 0;
+                    float minimum = values[q][first], maximum = values[q][first];
+
+                    for(int k = first; k <= i; k++)
+                    {
+                        double x = (k - first) * (SAMPLE_INTERVAL / 3600000.0);
+                        sx += x;
+                        sy += values[q][k];
+                        sxx += x * x;
+                        sxy += x * values[q][k];
+                        minimum = qMin(minimum, values[q][k]);
+                        maximum = qMax(maximum, values[q][k]);
+                    }
+
+                    double slope = n < 2 ? 0 : (sxy - sx * sy / n) / (sxx - sx * sx / n);
+
+                    max_error = qMax(max_error, relative_error(window.Count(), n));
+                    max_error = qMax(max_error, relative_error(window.Mean(), sy / n));
+                    max_error = qMax(max_error, relative_error(window.Minimum(), minimum));
+                    max_error = qMax(max_error, relative_error(window.Maximum(), maximum));
+                    max_error = qMax(max_error, relative_error(window.Change(), values[q][i] - values[q][first]));
+                    max_error = qMax(max_error, relative_error(window.Slope(), slope));
+                }
+            }
+        }
+
+        bench.Check("analytics_sample", max_error < 1e-6, "all windows match the brute force recomputation");
+
+        // A storm: the pressure falls 2 hPa per hour for 3 hours.
+        StreamAnalytics storm;
+        bool raised = false, cleared = false;
+        for(int i = 0; i < 12 * 60; i++)
+        {
+            float pressure = 1013 - 2.0f * qBound(0, i - 4 * 60, 3 * 60) / 60;
+            quint32 changed = storm.AddSample(QUANTITY_AIRPRESSURE, (int64_t)i * SAMPLE_INTERVAL, pressure);
+
+            if(changed & (1 << StreamAnalytics::ALERT_PRESSURE_FALLING))
+            {
+                raised |= storm.IsActive(StreamAnalytics::ALERT_PRESSURE_FALLING);
+                cleared |= raised && !storm.IsActive(StreamAnalytics::ALERT_PRESSURE_FALLING);
+            }
+        }
+        bench.Check("analytics_sample", raised && cleared, "falling pressure alert is raised and cleared");
+
+        StreamAnalytics timed;
+        bench.Run("analytics_sample", [&](qint64 i) {
+            WeatherQuantity q = (WeatherQuantity)(i % QUANTITY_COUNT);
+            timed.AddSample(q, (i / QUANTITY_COUNT) * SAMPLE_INTERVAL, values[q][(i / QUANTITY_COUNT) % SERIES_LENGTH]);
+        });
+        bench.AddMetric("analytics_sample", "windows_per_op", ANALYTICS_WINDOW_COUNT);
+        bench.AddMetric("analytics_sample", "max_relative_error", max_error);
+    }
+
+    // Many sensors, each with windows from 1 minute up to a day.
+    QString name = QString("slidingwindow_%1_sensors_%2_windows").arg(ANALYTICS_SENSORS).arg(ANALYTICS_WINDOWS);
+    if(bench.Selected(name))
+    {
+        QVector<SlidingWindow *> windows;
+
+        for(int s = 0; s < ANALYTICS_SENSORS; s++)
+            for(int w = 0; w < ANALYTICS_WINDOWS; w++)
+                windows.append(new SlidingWindow(60000LL << (w * 11 / ANALYTICS_WINDOWS)));
+
+        bench.Run(name, [&](qint64 i) {
+            int sensor = i % ANALYTICS_SENSORS;
+            int64_t time = (i / ANALYTICS_SENSORS) * SAMPLE_INTERVAL;
+            float value = values[sensor % QUANTITY_COUNT][(i / ANALYTICS_SENSORS) % SERIES_LENGTH];
+
+            for(int w = 0; w < ANALYTICS_WINDOWS; w++)
+                windows[sensor * ANALYTICS_WINDOWS + w]->AddSample(time, value);
+        });
+        bench.AddMetric(name, "windows_per_op", ANALYTICS_WINDOWS);
+
+        qDeleteAll(windows);
+    }
+}
+
+static void benchmark_database(Benchmark &bench, WeatherDatabase &weatherdatabase)
+/*
+ * Insert paths of the weatherdatabase on a local SQLite database.
+ */
+{
+    QVector<StationSample> samples(INSERT_BATCH_ROWS * 4);
+
+    bench.Run("database_insert_single", [&](qint64 i) {
+        weatherdatabase.AddTemperatureData(20.0f + (i % 100) / 10.0f,
+                                           QDateTime::fromMSecsSinceEpoch(i * SAMPLE_INTERVAL));
+    });
+
+    for(int i = 0; i < samples.size(); i++)
+    {
+        samples[i].station = i % 100;
+        samples[i].time = (qint64)i * SAMPLE_INTERVAL;
+        samples[i].quantity = i % QUANTITY_COUNT;
+        samples[i].value = i % 1000;
+    }
+
+    // One operation stores all samples in a single transaction.
+    bench.Run("database_insert_batch_2000", [&](qint64) {
+        weatherdatabase.AddStationData(samples);
+    });
+    bench.AddMetric("database_insert_batch_2000", "rows_per_op", samples.size());
+}
+
+static void benchmark_import(Benchmark &bench, WeatherDatabase &weatherdatabase, const QString &directory)
+/*
+ * Bulk import of a CSV dump: throughput, validation and deduplication when
+ * the same file is imported twice.
+ */
+{
+    QString filename = directory + "/import.csv";
+    QFile file(filename);
+    QByteArray csv = "datetime,temperature,humidity,airpressure\n";
+    QVector<float> values[QUANTITY_COUNT];
+    qint64 start = QDateTime(QDate(2030, 1, 1), QTime(0, 0)).toMSecsSinceEpoch();
+    int invalid = 0;
+
+    if(!bench.Selected("import_csv"))
+        return;
+
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+        series((WeatherQuantity)q, &values[q]);
+
+    for(int i = 0; i < IMPORT_ROWS; i++)
+    {
+        if(i % IMPORT_INVALID == IMPORT_INVALID - 1)
+        {
+            csv += "2030-13-45 00:00:00,12.5,,\n";
+            invalid++;
+            continue;
+        }
+
+        csv += QDateTime::fromMSecsSinceEpoch(start + (qint64)i * SAMPLE_INTERVAL)
+               .toString("yyyy-MM-dd HH:mm:ss").toLatin1();
+        for(int q = 0; q < QUANTITY_COUNT; q++)
+            csv += "," + QByteArray::number(values[q][i % SERIES_LENGTH], 'f', 2);
+        csv += "\n";
+    }
+
+    if(!file.open(QIODevice::WriteOnly) || file.write(csv) != csv.size())
+    {
+        bench.Check("import_csv", false, "import file can be written");
+        return;
+    }
+    file.close();
+
+    QElapsedTimer timer;
+    BulkImporter importer(&weatherdatabase, false);
+    long allocations = benchmark_allocations.load();
+
+    timer.start();
+    bool ok = importer.ImportFile(filename);
+    bench.AddResult("import_csv", IMPORT_ROWS, timer.nsecsElapsed(), benchmark_allocations.load() - allocations);
+
+    bench.AddMetric("import_csv", "rows_per_minute", IMPORT_ROWS * 60e9 / qMax(1.0, (double)timer.nsecsElapsed()));
+    bench.AddMetric("import_csv", "bytes", csv.size());
+    bench.AddMetric("import_csv", "imported", importer.Imported());
+    bench.Check("import_csv", ok && importer.Invalid() == invalid &&
+                importer.Imported() + importer.Duplicates() == (IMPORT_ROWS - invalid) * QUANTITY_COUNT,
+                "all valid samples are imported, invalid rows are skipped");
+
+    BulkImporter reimporter(&weatherdatabase, false);
+    timer.restart();
+    ok = reimporter.ImportFile(filename);
+    bench.AddResult("import_csv_duplicates", IMPORT_ROWS, timer.nsecsElapsed(), 0);
+    bench.Check("import_csv_duplicates", ok && reimporter.Imported() == 0 &&
+                reimporter.Duplicates() == (IMPORT_ROWS - invalid) * QUANTITY_COUNT,
+                "importing a file twice stores nothing");
+}
+
+static bool export_csv(WeatherDatabase &weatherdatabase, const QString &filename, qint64 from, qint64 to,
+                       qint64 *rows, qint64 *bytes)
+/*
+ * The equivalent CSV dump of the tables, read in the same chunks as the
+ * columnar export.
+ */
+{
+    const char *names[QUANTITY_COUNT] = { "temperature", "humidity", "airpressure" };
+    QSaveFile file(filename);
+
+    *rows = 0;
+    *bytes = 0;
+
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+    {
+        QByteArray header = QByteArray("datetime,") + names[q] + "\n";
+        file.write(header);
+        *bytes += header.size();
+
+        for(qint64 start = from; start < to; start += EXPORT_QUERY_SPAN)
+        {
+            QVector<qint64> times;
+            QVector<float> values;
+            QByteArray csv;
+
+            if(!weatherdatabase.ReadSamples((WeatherQuantity)q, start, qMin(to, start + EXPORT_QUERY_SPAN), &times, &values))
+                return false;
+
+            for(int i = 0; i < times.size(); i++)
+                csv += QDateTime::fromMSecsSinceEpoch(times[i]).toString("yyyy-MM-dd HH:mm:ss").toLatin1() + "," +
+                       QByteArray::number(values[i]) + "\n";
+
+            file.write(csv);
+            *rows += times.size();
+            *bytes += csv.size();
+        }
+    }
+
+    return file.commit();
+}
+
+static void benchmark_export(Benchmark &bench, WeatherDatabase &weatherdatabase, const QString &directory)
+/*
+ * Columnar export compared to the equivalent CSV dump: throughput and size,
+ * and verification of the exported file.
+ */
+{
+    QVector<float> values[QUANTITY_COUNT];
+    QVector<StationSample> samples;
+    QVector<WeatherQuantity> quantities;
+    qint64 from = QDateTime(QDate(2031, 1, 1), QTime(0, 0)).toMSecsSinceEpoch();
+    qint64 to = from + (qint64)EXPORT_ROWS * SAMPLE_INTERVAL;
+    QString filename = directory + "/export.wscol";
+    QElapsedTimer timer;
+    long allocations;
+
+    if(!bench.Selected("export_"))
+        return;
+
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+    {
+        series((WeatherQuantity)q, &values[q]);
+        quantities.append((WeatherQuantity)q);
+    }
+
+    for(int i = 0; i < EXPORT_ROWS; i++)
+    {
+        for(int q = 0; q < QUANTITY_COUNT; q++)
+        {
+            StationSample sample;
+            sample.station = 0;
+            sample.time = from + (qint64)i * SAMPLE_INTERVAL;
+            sample.quantity = q;
+            sample.value = values[q][i % SERIES_LENGTH];
+            samples.append(sample);
+        }
+    }
+
+    if(!weatherdatabase.AddBulkData(samples))
+    {
+        bench.Check("export_columnar", false, "export data can be stored");
+        return;
+    }
+
+    ColumnExporter exporter(&weatherdatabase, false);
+    allocations = benchmark_allocations.load();
+    timer.start();
+    bool ok = exporter.Export(filename, from, to, quantities);
+    bench.AddResult("export_columnar", qMax((qint64)1, exporter.Rows()), timer.nsecsElapsed(),
+                    benchmark_allocations.load() - allocations);
+
+    qint64 csv_rows, csv_bytes;
+    timer.restart();
+    bool csv_ok = export_csv(weatherdatabase, directory + "/export.csv", from, to, &csv_rows, &csv_bytes);
+    bench.AddResult("export_csv", qMax((qint64)1, csv_rows), timer.nsecsElapsed(), 0);
+
+    bench.AddMetric("export_columnar", "rows", exporter.Rows());
+    bench.AddMetric("export_columnar", "bytes", exporter.Bytes());
+    bench.AddMetric("export_columnar", "bytes_per_row", (double)exporter.Bytes() / qMax((qint64)1, exporter.Rows()));
+    bench.AddMetric("export_csv", "bytes", csv_bytes);
+    bench.AddMetric("export_csv", "bytes_per_row", (double)csv_bytes / qMax((qint64)1, csv_rows));
+    bench.AddMetric("export_columnar", "csv_size_ratio", (double)csv_bytes / qMax((qint64)1, exporter.Bytes()));
+
+    // The file must hold exactly the stored samples, in time order per quantity.
+    QVector<StationSample> exported;
+    int next[QUANTITY_COUNT] = { 0, 0, 0 };
+    bool equal = ok && csv_ok && ColumnExporter::ReadFile(filename, &exported) && exported.size() == samples.size();
+
+    for(int i = 0; equal && i < exported.size(); i++)
+    {
+        const StationSample &sample = exported[i];
+        int index = next[sample.quantity]++ * QUANTITY_COUNT + sample.quantity;
+
+        equal = sample.time == samples[index].time && sample.value == samples[index].value;
+    }
+    bench.Check("export_columnar", equal, "exported file matches the stored samples");
+
+    // Projection and time range: a single quantity for 30 days.
+    ColumnExporter projected(&weatherdatabase, false);
+    QVector<WeatherQuantity> temperature;
+    temperature.append(QUANTITY_TEMPERATURE);
+
+    timer.restart();
+    ok = projected.Export(directory + "/projected.wscol", from, from + 30 * EXPORT_QUERY_SPAN, temperature);
+    bench.AddResult("export_columnar_projected", qMax((qint64)1, projected.Rows()), timer.nsecsElapsed(), 0);
+    bench.Check("export_columnar_projected", ok && projected.Rows() == 30 * 24 * 60,
+                "only the selected quantity and range are exported");
+}
+
+static void benchmark_imagestore(Benchmark &bench)
+/*
+ * Hashing and change detection per frame, and the storage saved on a
+ * sequence with static, slowly changing and changing scenes.
+ */
+{
+    QVector<QByteArray> frames;
+    qint64 total_bytes = 0;
+
+    if(!bench.Selected("imagestore_frame"))
+        return;
+
+    for(int i = 0; i < 60; i++)
+    {
+        if(i < 20)
+            frames.append(jpeg_frame(20, 100, 1));              // night, identical frames
+        else if(i < 40)
+            frames.append(jpeg_frame(120 + i / 4, 100, i));      // day, only noise changes
+        else
+            frames.append(jpeg_frame(120, 100 + (i - 40) * 8, i)); // moving object
+        total_bytes += frames.last().size();
+    }
+
+    ImageStore classify(NULL);
+    for(int i = 0; i < frames.size(); i++)
+        classify.AddImage(frames[i], QDateTime::currentDateTime());
+
+    ImageStore timed(NULL);
+    bench.Run("imagestore_frame", [&](qint64 i) {
+        timed.AddImage(frames[i % frames.size()], QDateTime::currentDateTime());
+    });
+
+    bench.AddMetric("imagestore_frame", "frames", classify.Frames());
+    bench.AddMetric("imagestore_frame", "stored_frames", classify.StoredFrames());
+    bench.AddMetric("imagestore_frame", "bytes_in", total_bytes);
+    bench.AddMetric("imagestore_frame", "bytes_saved", classify.BytesSaved());
+    bench.Check("imagestore_frame", classify.StoredFrames() < classify.Frames() / 2 && classify.StoredFrames() > 2,
+                "static scenes are skipped, changes are stored");
+}
+
+static void benchmark_imagestorage(Benchmark &bench, WeatherDatabase &weatherdatabase)
+/*
+ * Storage of the frames by content hash: a day with a static night, an
+ * object moving back and forth, so scenes recur, and the dedup ratio of the
+ * stored image bytes.
+ */
+{
+    QVector<QByteArray> frames;
+    QElapsedTimer timer;
+    QSqlQuery query;
+    qint64 total_bytes = 0;
+    long allocations;
+
+    if(!bench.Selected("imagestore_storage"))
+        return;
+
+    for(int i = 0; i < 120; i++)
+    {
+        int position = abs(i % 8 - 4);
+
+        if(i < 40)
+            frames.append(jpeg_frame(20, 100, 1));                      // night, identical frames
+        else
+            frames.append(jpeg_frame(120, 100 + position * 40, position)); // recurring scenes
+        total_bytes += frames.last().size();
+    }
+
+    query.exec("DELETE FROM imageframes");
+    query.exec("DELETE FROM imageindex");
+
+    ImageStore store(&weatherdatabase);
+    allocations = benchmark_allocations.load();
+    timer.start();
+
+    for(int i = 0; i < frames.size(); i++)
+        store.AddImage(frames[i], QDateTime::fromMSecsSinceEpoch((qint64)i * SAMPLE_INTERVAL));
+
+    bench.AddResult("imagestore_storage", frames.size(), timer.nsecsElapsed(),
+                    benchmark_allocations.load() - allocations);
+
+    qint64 distinct_frames = 0, stored_bytes = 0, index_rows = 0;
+
+    if(query.exec("SELECT COUNT(*), SUM(LENGTH(image)) FROM imageframes") && query.next())
+    {
+        distinct_frames = query.value(0).toLongLong();
+        stored_bytes = query.value(1).toLongLong();
+    }
+    if(query.exec("SELECT COUNT(*) FROM imageindex") && query.next())
+        index_rows = query.value(0).toLongLong();
+
+    bench.AddMetric("imagestore_storage", "frames", store.Frames());
+    bench.AddMetric("imagestore_storage", "stored_frames", store.StoredFrames());
+    bench.AddMetric("imagestore_storage", "distinct_frames", distinct_frames);
+    bench.AddMetric("imagestore_storage", "bytes_in", total_bytes);
+    bench.AddMetric("imagestore_storage", "bytes_stored", stored_bytes);
+    bench.AddMetric("imagestore_storage", "dedup_ratio", stored_bytes > 0 ? (double)total_bytes / stored_bytes : 0.0);
+    bench.Check("imagestore_storage", index_rows == store.StoredFrames(), "every stored frame is indexed");
+    bench.Check("imagestore_storage", distinct_frames > 1 && distinct_frames < store.StoredFrames(),
+                "recurring scenes are stored once");
+}
+
+static void benchmark_sharedmemory(Benchmark &bench)
+/*
+ * Seqlock reads of the latest reading, without and with a writer and many
+ * concurrent readers, the latency until a published reading is seen and the
+ * aggregate read throughput. Every snapshot must be consistent.
+ */
+{
+    const char *segment = "/weatherstation-benchmark";
+    WeatherPublisher publisher;
+    WeatherReader reader;
+    WeatherReading reading;
+
+    memset(&reading, 0, sizeof(reading));
+
+    if(!publisher.Open(segment) || !reader.Open(segment))
+    {
+        bench.Check("shm_read", false, "shared memory segment can be opened");
+        return;
+    }
+
+    reading.count = 1;
+    publisher.Publish(reading);
+
+    bench.Run("shm_read_uncontended", [&](qint64) {
+        WeatherReading snapshot;
+        reader.Read(&snapshot);
+    });
+
+    if(bench.Selected("shm_read_contended"))
+    {
+        std::atomic<bool> stop(false);
+        std::atomic<long> inconsistent(0);
+        std::vector<std::thread> threads;
+
+        // The writer publishes readings in which all values are equal, a
+        // torn snapshot shows up as values that differ.
+        threads.push_back(std::thread([&]() {
+            WeatherReading update;
+            memset(&update, 0, sizeof(update));
+            for(uint64_t n = 1; !stop.load(); n++)
+            {
+                update.count = n;
+                update.time = update.dht22_time = update.bmp085_time = n;
+                update.temperature = update.humidity = update.airpressure = (float)(n & 0xFFFF);
+                publisher.Publish(update);
+            }
+        }));
+
+        for(int i = 1; i < CONTENDED_READERS; i++)
+        {
+            threads.push_back(std::thread([&]() {
+                WeatherReading snapshot;
+                while(!stop.load())
+                    if(reader.Read(&snapshot) && (snapshot.time != snapshot.bmp085_time ||
+                                                  snapshot.temperature != snapshot.airpressure))
+                        inconsistent++;
+            }));
+        }
+
+        QString name = QString("shm_read_contended_%1_readers").arg(CONTENDED_READERS);
+        bench.Run(name, [&](qint64) {
+            WeatherReading snapshot;
+            if(reader.Read(&snapshot) && snapshot.time != snapshot.dht22_time)
+                inconsistent++;
+        });
+
+        stop.store(true);
+        for(size_t i = 0; i < threads.size(); i++)
+            threads[i].join();
+
+        bench.Check(name, inconsistent.load() == 0, "all snapshots are consistent");
+    }
+
+    bench.Run("shm_publish", [&](qint64 i) {
+        reading.count = i + 1;
+        publisher.Publish(reading);
+    });
+
+    if(bench.Selected("shm_publish_latency"))
+    {
+        std::atomic<uint64_t> seen(0);
+        std::vector<qint64> latencies;
+        QElapsedTimer timer;
+
+        latencies.reserve(LATENCY_SAMPLES);
+
+        reading.count = 0;
+        publisher.Publish(reading);
+
+        // The reader acknowledges every reading it sees, the writer only
+        // publishes the next reading after the acknowledgement. The time
+        // from publishing until a reader holds the snapshot is recorded.
+        std::thread consumer([&]() {
+            WeatherReading snapshot;
+            uint64_t last = 0;
+            while(last < LATENCY_SAMPLES)
+            {
+                if(reader.Read(&snapshot) && snapshot.count != last)
+                {
+                    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count() - snapshot.time);
+                    last = snapshot.count;
+                    seen.store(last, std::memory_order_release);
+                }
+            }
+        });
+
+        long allocations = benchmark_allocations.load();
+        timer.start();
+
+        for(uint64_t n = 1; n <= LATENCY_SAMPLES; n++)
+        {
+            reading.count = n;
+            reading.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            publisher.Publish(reading);
+            while(seen.load(std::memory_order_acquire) != n)
+                ;
+        }
+
+        qint64 nsecs = timer.nsecsElapsed();
+        consumer.join();
+
+        bench.AddResult("shm_publish_latency", LATENCY_SAMPLES, nsecs, benchmark_allocations.load() - allocations);
+
+        std::sort(latencies.begin(), latencies.end());
+        bench.AddMetric("shm_publish_latency", "p50_ns", latencies[latencies.size() / 2]);
+        bench.AddMetric("shm_publish_latency", "p99_ns", latencies[latencies.size() * 99 / 100]);
+        bench.AddMetric("shm_publish_latency", "max_ns", latencies.back());
+    }
+
+    QString throughput_name = QString("shm_read_throughput_%1_readers").arg(CONTENDED_READERS);
+    if(bench.Selected(throughput_name))
+    {
+        std::atomic<bool> stop(false);
+        std::atomic<long> reads(0);
+        std::vector<std::thread> threads;
+        QElapsedTimer timer;
+
+        // Total snapshots per second of all readers while readings are
+        // published once per msec, far more often than the station does.
+        timer.start();
+
+        for(int i = 0; i < CONTENDED_READERS; i++)
+        {
+            threads.push_back(std::thread([&]() {
+                WeatherReading snapshot;
+                long count = 0;
+                while(!stop.load(std::memory_order_relaxed))
+                    if(reader.Read(&snapshot))
+                        count++;
+                reads += count;
+            }));
+        }
+
+        for(uint64_t n = 1; timer.nsecsElapsed() < BENCHMARK_MIN_TIME; n++)
+        {
+            reading.count = n;
+            publisher.Publish(reading);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        stop.store(true);
+        for(size_t i = 0; i < threads.size(); i++)
+            threads[i].join();
+
+        qint64 nsecs = timer.nsecsElapsed();
+
+        bench.AddResult(throughput_name, qMax(1L, reads.load()), nsecs, 0);
+        bench.AddMetric(throughput_name, "reads_per_sec", reads.load() * 1e9 / nsecs);
+    }
+
+    publisher.Close();
+    reader.Close();
+    shm_unlink(segment);
+}
+
+static int take_responses(QByteArray *buffer)
+/*
+ * Remove the complete responses from the data received on a keep-alive
+ * connection.
+ */
+{
+    int responses = 0;
+    int end;
+
+    while((end = buffer->indexOf("\r\n\r\n")) != -1)
+    {
+        int start = buffer->indexOf("Content-Length: ");
+        int length = 0;
+
+        if(start != -1 && start < end)
+            length = buffer->mid(start + 16, buffer->indexOf("\r\n", start) - start - 16).toInt();
+
+        if(buffer->size() < end + 4 + length)
+            break;
+
+        buffer->remove(0, end + 4 + length);
+        responses++;
+    }
+
+    return responses;
+}
+
+template<typename Condition>
+static bool wait_until(Condition condition, int timeout)
+/*
+ * Run the event loop until the condition holds or the timeout (msec)
+ * expired.
+ */
+{
+    QEventLoop loop;
+    QTimer poll;
+    QElapsedTimer timer;
+
+    timer.start();
+    QObject::connect(&poll, &QTimer::timeout, [&]() {
+        if(condition() || timer.elapsed() > timeout)
+            loop.quit();
+    });
+    poll.start(1);
+
+    if(!condition())
+        loop.exec();
+
+    return condition();
+}
+
+static qint64 steady_nsecs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void benchmark_http(Benchmark &bench)
+/*
+ * HTTP interface on the loopback, served from its own thread as on the
+ * station: requests per second of /latest over keep-alive connections, and
+ * the time from publishing a reading until each of HTTP_SUBSCRIBERS /events
+ * subscribers received it.
+ */
+{
+    QString fanout_name = QString("http_events_fanout_%1").arg(HTTP_SUBSCRIBERS);
+    QThread thread;
+    HttpServer *server;
+    WeatherReading reading;
+
+    if(!bench.Selected("http_latest_requests") && !bench.Selected(fanout_name))
+        return;
+
+    server = new HttpServer(QHostAddress::LocalHost, 0, false);
+    server->moveToThread(&thread);
+    QObject::connect(&thread, SIGNAL(finished()), server, SLOT(deleteLater()));
+    thread.start();
+    QMetaObject::invokeMethod(server, "Start", Qt::BlockingQueuedConnection);
+
+    memset(&reading, 0, sizeof(reading));
+    reading.count = 1;
+    reading.status = WEATHER_STATUS_DHT22_VALID | WEATHER_STATUS_BMP085_VALID;
+    QMetaObject::invokeMethod(server, "PublishReading", Qt::BlockingQueuedConnection,
+                              Q_ARG(WeatherReading, reading), Q_ARG(QByteArray, QByteArray()));
+
+    if(server->Port() == 0)
+    {
+        bench.Check("http_latest_requests", false, "HTTP server listens on the loopback");
+        thread.quit();
+        thread.wait();
+        return;
+    }
+
+    if(bench.Selected("http_latest_requests"))
+    {
+        QVector<QTcpSocket *> clients;
+        QVector<QByteArray> buffers(HTTP_CONNECTIONS);
+        QByteArray request = "GET /latest HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        QElapsedTimer timer;
+        qint64 responses = 0, requests = 0;
+        bool running = true;
+
+        for(int i = 0; i < HTTP_CONNECTIONS; i++)
+        {
+            QTcpSocket *client = new QTcpSocket();
+
+            // Every client sends its next request as soon as the previous
+            // response is complete.
+            QObject::connect(client, &QTcpSocket::readyRead, [&, i, client]() {
+                buffers[i] += client->readAll();
+                for(int n = take_responses(&buffers[i]); n > 0; n--)
+                {
+                    responses++;
+                    if(running)
+                    {
+                        client->write(request);
+                        requests++;
+                    }
+                }
+            });
+
+            client->connectToHost(QHostAddress::LocalHost, server->Port());
+            clients.append(client);
+        }
+
+        bool connected = wait_until([&]() -> bool {
+            foreach(QTcpSocket *client, clients)
+                if(client->state() != QAbstractSocket::ConnectedState)
+                    return false;
+            return true;
+        }, 5000);
+
+        long allocations = benchmark_allocations.load();
+        timer.start();
+
+        foreach(QTcpSocket *client, clients)
+        {
+            client->write(request);
+            requests++;
+        }
+
+        wait_until([&]() { return timer.nsecsElapsed() >= BENCHMARK_MIN_TIME; }, 60000);
+        running = false;
+        wait_until([&]() { return responses == requests; }, 5000);
+
+        qint64 nsecs = timer.nsecsElapsed();
+
+        bench.AddResult("http_latest_requests", qMax(1LL, responses), nsecs, benchmark_allocations.load() - allocations);
+        bench.AddMetric("http_latest_requests", "connections", HTTP_CONNECTIONS);
+        bench.AddMetric("http_latest_requests", "requests_per_sec", responses * 1e9 / nsecs);
+        bench.Check("http_latest_requests", connected && responses == requests && responses > 0,
+                    "every request is answered");
+
+        qDeleteAll(clients);
+    }
+
+    if(bench.Selected(fanout_name))
+    {
+        QVector<QTcpSocket *> clients;
+        QVector<QByteArray> buffers(HTTP_SUBSCRIBERS);
+        QVector<quint64> received(HTTP_SUBSCRIBERS, 0);
+        std::vector<qint64> latencies, fanouts;
+        QByteArray request = "GET /events HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        quint64 published = reading.count;
+        qint64 published_time = 0;
+        qint64 fanout_time = 0;
+        int delivered = 0, subscribed = 0;
+
+        latencies.reserve(HTTP_SUBSCRIBERS * HTTP_EVENTS);
+
+        for(int i = 0; i < HTTP_SUBSCRIBERS; i++)
+        {
+            QTcpSocket *client = new QTcpSocket();
+
+            // Events are separated by an empty line, the count of a reading
+            // tells whether it is the one published last.
+            QObject::connect(client, &QTcpSocket::readyRead, [&, i, client]() {
+                int end;
+
+                buffers[i] += client->readAll();
+
+                if(received[i] == 0 && (end = buffers[i].indexOf("\r\n\r\n")) != -1)
+                {
+                    buffers[i].remove(0, end + 4);
+                    received[i] = 1;
+                    subscribed++;
+                }
+
+                while(received[i] > 0 && (end = buffers[i].indexOf("\n\n")) != -1)
+                {
+                    QByteArray event = buffers[i].left(end);
+                    int position = event.indexOf("\"count\":");
+
+                    buffers[i].remove(0, end + 2);
+
+                    if(!event.startsWith("event: reading") || position == -1)
+                        continue;
+
+                    quint64 count = event.mid(position + 8).split(',').first().toULongLong();
+                    if(count == published && count > received[i])
+                    {
+                        qint64 latency = steady_nsecs() - published_time;
+                        latencies.push_back(latency);
+                        fanout_time = qMax(fanout_time, latency);
+                        received[i] = count;
+                        delivered++;
+                    }
+                }
+            });
+
+            client->connectToHost(QHostAddress::LocalHost, server->Port());
+            client->write(request);
+            clients.append(client);
+        }
+
+        bool connected = wait_until([&]() { return subscribed == HTTP_SUBSCRIBERS; }, 10000);
+        long allocations = benchmark_allocations.load();
+        qint64 nsecs = 0;
+
+        for(int k = 0; connected && k < HTTP_EVENTS; k++)
+        {
+            delivered = 0;
+            fanout_time = 0;
+            reading.count = ++published;
+            published_time = steady_nsecs();
+
+            QMetaObject::invokeMethod(server, "PublishReading", Qt::QueuedConnection,
+                                      Q_ARG(WeatherReading, reading), Q_ARG(QByteArray, QByteArray()));
+
+            if(!wait_until([&]() { return delivered == HTTP_SUBSCRIBERS; }, 5000))
+                break;
+
+            fanouts.push_back(fanout_time);
+            nsecs += fanout_time;
+        }
+
+        // One operation is a reading that reached every subscriber.
+        bench.AddResult(fanout_name, qMax((size_t)1, fanouts.size()), nsecs, benchmark_allocations.load() - allocations);
+
+        if(!latencies.empty() && !fanouts.empty())
+        {
+            std::sort(latencies.begin(), latencies.end());
+            std::sort(fanouts.begin(), fanouts.end());
+            bench.AddMetric(fanout_name, "subscribers", HTTP_SUBSCRIBERS);
+            bench.AddMetric(fanout_name, "delivery_p50_ns", latencies[latencies.size() / 2]);
+            bench.AddMetric(fanout_name, "delivery_p99_ns", latencies[latencies.size() * 99 / 100]);
+            bench.AddMetric(fanout_name, "fanout_p50_ns", fanouts[fanouts.size() / 2]);
+            bench.AddMetric(fanout_name, "fanout_max_ns", fanouts.back());
+        }
+        bench.Check(fanout_name, connected && (int)fanouts.size() == HTTP_EVENTS,
+                    "every reading reaches every subscriber");
+
+        qDeleteAll(clients);
+    }
+
+    thread.quit();
+    thread.wait();
+}
+
+static void benchmark_acquisition(Benchmark &bench, WeatherDatabase &weatherdatabase)
+/*
+ * A complete acquisition cycle against simulated sensors: decode, compensate,
+ * compress, store and publish.
+ */
+{
+    const char *segment = "/weatherstation-benchmark";
+    QVector<QLinkedList<long> > traces;
+    SwingingDoor *doors[QUANTITY_COUNT];
+    WeatherPublisher publisher;
+    WeatherReading reading;
+    BMP085 bmp085;
+
+    if(!bench.Selected("acquisition_cycle"))
+        return;
+
+    for(int i = 0; i < 64; i++)
+    {
+        int data[5];
+        dht22_frame(10 + sin(i / 10.0) * 5, 60 + i % 10, data);
+        traces.append(dht22_trace(data, i));
+    }
+
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+        doors[q] = new SwingingDoor(0.1f, 900000);
+
+    bmp085.load_calibration_data(bmp085_eeprom);
+    publisher.Open(segment);
+    memset(&reading, 0, sizeof(reading));
+
+    bench.Run("acquisition_cycle", [&](qint64 i) {
+        SwingingDoorSample sample, output[SWINGINGDOOR_MAX_OUTPUT];
+        float values[QUANTITY_COUNT];
+
+        sample.time = i * SAMPLE_INTERVAL;
+
+        DHT22Sensor::DecodePulses(traces[i % traces.size()], &values[QUANTITY_TEMPERATURE], &values[QUANTITY_HUMIDITY]);
+        bmp085.compensate_pressure(BMP085_EXAMPLE_UT + (i & 15), BMP085_EXAMPLE_UP + (i & 63), &values[QUANTITY_AIRPRESSURE]);
+
+        reading.time = sample.time;
+        reading.count++;
+        reading.temperature = values[QUANTITY_TEMPERATURE];
+        reading.humidity = values[QUANTITY_HUMIDITY];
+        reading.airpressure = values[QUANTITY_AIRPRESSURE];
+        publisher.Publish(reading);
+
+        for(int q = 0; q < QUANTITY_COUNT; q++)
+        {
+            sample.value = values[q];
+            int count = doors[q]->AddSample(sample, output);
+            for(int j = 0; j < count; j++)
+                weatherdatabase.AddData((WeatherQuantity)q, output[j].value,
+                                        QDateTime::fromMSecsSinceEpoch(output[j].time));
+        }
+    });
+
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+        delete doors[q];
+
+    publisher.Close();
+    shm_unlink(segment);
+}
+
+int main(int argc, char *argv[])
+{
+    // Generated series are in local time, without daylight saving time
+    // they map to stored DATETIME values and back without ambiguity.
+    qputenv("TZ", "UTC");
+    tzset();
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Raspberry Weatherstation benchmark");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks of the weatherstation");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption filterOption(QStringList() << "filter", "Only run benchmarks containing <name>", "name");
+    parser.addOption(filterOption);
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Write the JSON results to <file>", "file");
+    parser.addOption(outputOption);
+    QCommandLineOption baselineOption(QStringList() << "baseline", "Compare against the JSON results in <file>", "file");
+    parser.addOption(baselineOption);
+    QCommandLineOption thresholdOption(QStringList() << "threshold", "Allowed slowdown in percent", "percent", "10");
+    parser.addOption(thresholdOption);
+
+    // Process the actual command line arguments given by the user
+    parser.process(app);
+
+    Benchmark bench(parser.value(filterOption));
+    QTemporaryDir directory;
+    WeatherDatabase weatherdatabase("QSQLITE", directory.path() + "/benchmark.sqlite");
+
+    weatherdatabase.OpenDatabase();
+
+    benchmark_sensors(bench);
+    benchmark_swingingdoor(bench);
+    benchmark_analytics(bench);
+    benchmark_database(bench, weatherdatabase);
+    benchmark_import(bench, weatherdatabase, directory.path());
+    benchmark_export(bench, weatherdatabase, directory.path());
+    benchmark_imagestore(bench);
+    benchmark_imagestorage(bench, weatherdatabase);
+    benchmark_sharedmemory(bench);
+    benchmark_http(bench);
+    benchmark_acquisition(bench, weatherdatabase);
+
+    weatherdatabase.CloseDatabase();
+
+    QByteArray json = bench.ToJson().toJson();
+
+    if(parser.isSet(outputOption))
+    {
+        QFile output(parser.value(outputOption));
+        if(output.open(QIODevice::WriteOnly))
+            output.write(json);
+    }
+    else
+    {
+        fwrite(json.constData(), 1, json.size(), stdout);
+    }
+
+    int regressions = 0;
+
+    if(parser.isSet(baselineOption))
+    {
+        QFile baseline(parser.value(baselineOption));
+
+        if(baseline.open(QIODevice::ReadOnly))
+            regressions = bench.CompareBaseline(QJsonDocument::fromJson(baseline.readAll()),
+                                                parser.value(thresholdOption).toDouble());
+        else
+            qWarning() << "Unable to read baseline" << parser.value(baselineOption);
+    }
+
+    return (bench.Failures() > 0 || regressions > 0) ? 1 : 0;
+}
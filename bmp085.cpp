@@ -31,6 +31,12 @@ void BMP085::initsensor()
         this->read_calibration_data();
 }
 
+bool BMP085::is_initialized()
+    /* Indicates whether the sensor could be reached */
+{
+    return this->sensor_initialized;
+}
+
 void BMP085::read_temperature(float *temperature)
     /* Gets the compensated temperature in degrees celcius */
 {
@@ -52,6 +58,17 @@ void BMP085::read_pressure(float *pressure)
 {
   long UT = 0;
   long UP = 0;
+
+  this->read_raw_temp((int*)&UT);
+  this->read_raw_pressure((int*)&UP);
+
+  this->compensate_pressure(UT, UP, pressure);
+}
+
+void BMP085::compensate_pressure(long UT, long UP, float *pressure)
+  /* Calculates the compensated pressure in hPa from the raw temperature and
+     pressure, using the calibration data (see the BMP085 datasheet) */
+{
   long B3 = 0;
   long B5 = 0;
   long B6 = 0;
@@ -62,9 +79,6 @@ void BMP085::read_pressure(float *pressure)
   unsigned long B4 = 0;
   unsigned long B7 = 0;
 
-  this->read_raw_temp((int*)&UT);
-  this->read_raw_pressure((int*)&UP);
-
   // True Temperature Calculations
   X1 = ((UT - this->cal_AC6) * this->cal_AC5) >> 15;
   X2 = (this->cal_MC << 11) / (X1 + this->cal_MD);
@@ -122,6 +136,29 @@ void BMP085::read_calibration_data()
     readS16(BMP085_CAL_MD, &(this->cal_MD));     // INT16
 }
 
+void BMP085::load_calibration_data(const uint8_t *eeprom)
+    /* Loads the calibration data from a copy of the 22 byte EEPROM
+       (0xAA - 0xBF), e.g. to run the compensation without the sensor */
+{
+    this->cal_AC1 = (short)((eeprom[0] << 8) | eeprom[1]);
+    this->cal_AC2 = (short)((eeprom[2] << 8) | eeprom[3]);
+    this->cal_AC3 = (short)((eeprom[4] << 8) | eeprom[5]);
+    this->cal_AC4 = (unsigned short)((eeprom[6] << 8) | eeprom[7]);
+    this->cal_AC5 = (unsigned short)((eeprom[8] << 8) | eeprom[9]);
+    this->cal_AC6 = (unsigned short)((eeprom[10] << 8) | eeprom[11]);
+    this->cal_B1 = (short)((eeprom[12] << 8) | eeprom[13]);
+    this->cal_B2 = (short)((eeprom[14] << 8) | eeprom[15]);
+    this->cal_MB = (short)((eeprom[16] << 8) | eeprom[17]);
+    this->cal_MC = (short)((eeprom[18] << 8) | eeprom[19]);
+    this->cal_MD = (short)((eeprom[20] << 8) | eeprom[21]);
+}
+
+void BMP085::set_mode(int mode)
+    /* Selects the oversampling mode (BMP085_ULTRALOWPOWER - BMP085_ULTRAHIGHRES) */
+{
+    this->mode = mode;
+}
+
 void BMP085::show_calibration_data()
     /* Displays the calibration values for debugging purposes */
 {
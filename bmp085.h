@@ -45,6 +45,10 @@ public:
     void read_temperature(float *temperature);
     void read_pressure(float *pressure);
     void read_altitude(float *altitude);
+    bool is_initialized();
+    void load_calibration_data(const uint8_t *eeprom);
+    void set_mode(int mode);
+    void compensate_pressure(long UT, long UP, float *pressure);
 private:
     void show_calibration_data();
     void read_calibration_data();
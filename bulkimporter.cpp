@@ -0,0 +1,621 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class imports readings from CSV dumps and logger files
+ *              into the weatherdatabase, e.g. to migrate a station or to
+ *              backfill an outage.
+ *
+ *              Files are memory mapped in windows of IMPORT_MAP_SIZE and
+ *              parsed in place, so the memory use does not depend on the
+ *              size of the file. The values are parsed by hand, they are
+ *              never copied into strings.
+ *              Valid samples are collected in chunks which are stored in a
+ *              single transaction with multi-row inserts. Samples that are
+ *              already stored, or occur twice in the file, are skipped. As
+ *              files are mostly sorted by time, the stored times are only
+ *              read for chunks that overlap the stored data.
+ */
+
+#include "bulkimporter.h"
+#include <QFile>
+#include <QSet>
+#include <QDebug>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+#include <limits.h>
+
+#define EPOCH_JULIAN_DAY    (2440588)   // 1970-01-01
+#define MSEC_PER_DAY        (86400000LL)
+#define MSEC_PER_HOUR       (3600000LL)
+#define EPOCH_MSEC_MIN      (100000000000LL)    // smaller epoch times are in seconds
+
+// Measurement range of the sensors, values outside are invalid.
+static const float value_limits[QUANTITY_COUNT][2] =
+{
+    { -40.0f, 80.0f },      // DHT22 temperature (degrees celcius)
+    { 0.0f, 100.0f },       // DHT22 humidity (%)
+    { 300.0f, 1100.0f }     // BMP085 air pressure (hPa)
+};
+
+static void trim_field(const char **begin, const char **end);
+static bool parse_value(const char *begin, const char *end, float *value);
+static int parse_digits(const char *begin, int count);
+static bool all_digits(const char *begin, const char *end);
+
+BulkImporter::BulkImporter(WeatherDatabase *weatherdatabase, bool debugmode)
+/*
+ * Constructor.
+ *
+ * in:  weatherdatabase Opened database to import the readings into.
+ *      debugmode       Report the invalid rows.
+ * out: none
+ */
+{
+    this->weatherdatabase = weatherdatabase;
+    this->debugmode = debugmode;
+
+    this->separator = ',';
+    this->time_column = -1;
+    this->column_count = 0;
+
+    for(int i = 0; i < QUANTITY_COUNT; i++)
+        this->range_read[i] = false;
+
+    this->cached_hour = LLONG_MIN;
+    this->cached_offset = 0;
+
+    this->rows = 0;
+    this->imported = 0;
+    this->duplicates = 0;
+    this->invalid = 0;
+
+    this->chunk.reserve(IMPORT_CHUNK_ROWS + QUANTITY_COUNT);
+}
+
+bool BulkImporter::ImportFile(const QString &filename)
+/*
+ * Import all readings of a file.
+ *
+ * in:  filename CSV file with a header line.
+ * out: return   False if the file could not be read or the readings could
+ *               not be stored. The readings of the chunks stored before
+ *               remain in the database, the rest of the file is discarded
+ *               so it does not end up with the readings of the next file.
+ */
+{
+    if(ReadFile(filename))
+        return true;
+
+    this->chunk.clear();
+
+    // The ranges may include samples that were never stored.
+    for(int i = 0; i < QUANTITY_COUNT; i++)
+        this->range_read[i] = false;
+
+    return false;
+}
+
+bool BulkImporter::ReadFile(const QString &filename)
+/*
+ * Parse a file and store its readings chunk by chunk, see ImportFile().
+ */
+{
+    QFile file(filename);
+    qint64 position = 0;
+    bool header = false;
+    long page = sysconf(_SC_PAGESIZE);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Import: unable to open" << filename << ":" << file.errorString();
+        return false;
+    }
+
+    if(!this->clock.isValid())
+        this->clock.start();
+    this->report_clock.start();
+
+    while(position < file.size())
+    {
+        qint64 length = qMin((qint64)IMPORT_MAP_SIZE, file.size() - position);
+        uchar *data = file.map(position, length);
+
+        if(data == NULL)
+        {
+            qWarning() << "Import: unable to map" << filename << ":" << file.errorString();
+            return false;
+        }
+
+        // The window is read once from front to back.
+        uintptr_t start = (uintptr_t)data & ~(uintptr_t)(page - 1);
+        madvise((void *)start, length + ((uintptr_t)data - start), MADV_SEQUENTIAL);
+
+        const char *begin = (const char *)data;
+        const char *end = begin + length;
+        const char *line = begin;
+
+        while(line < end)
+        {
+            const char *newline = (const char *)memchr(line, '\n', end - line);
+
+            // A line that continues beyond the window is parsed in the next one.
+            if(newline == NULL)
+            {
+                if(position + length < file.size())
+                    break;
+                newline = end;
+            }
+
+            if(header)
+            {
+                ParseLine(line, newline);
+            }
+            else if(ParseHeader(line, newline))
+            {
+                header = true;
+            }
+            else
+            {
+                file.unmap(data);
+                return false;
+            }
+
+            line = newline < end ? newline + 1 : end;
+
+            if(this->chunk.size() >= IMPORT_CHUNK_ROWS)
+            {
+                if(!FlushChunk())
+                {
+                    file.unmap(data);
+                    return false;
+                }
+
+                if(this->report_clock.elapsed() >= IMPORT_REPORT_INTERVAL)
+                {
+                    Report(filename, position + (line - begin), file.size());
+                    this->report_clock.restart();
+                }
+            }
+        }
+
+        file.unmap(data);
+
+        if(line == begin)
+        {
+            qWarning() << "Import: line longer than" << IMPORT_MAP_SIZE << "bytes in" << filename;
+            return false;
+        }
+
+        position += line - begin;
+    }
+
+    if(!header)
+    {
+        qWarning() << "Import:" << filename << "is empty";
+        return false;
+    }
+
+    if(!FlushChunk())
+        return false;
+
+    Report(filename, position, file.size());
+
+    return true;
+}
+
+qint64 BulkImporter::Rows() const
+/*
+ * Number of rows read from the files.
+ */
+{
+    return this->rows;
+}
+
+qint64 BulkImporter::Imported() const
+/*
+ * Number of samples stored in the database.
+ */
+{
+    return this->imported;
+}
+
+qint64 BulkImporter::Duplicates() const
+/*
+ * Number of samples skipped because they were stored before.
+ */
+{
+    return this->duplicates;
+}
+
+qint64 BulkImporter::Invalid() const
+/*
+ * Number of rows skipped because of an invalid time or value.
+ */
+{
+    return this->invalid;
+}
+
+bool BulkImporter::ParseHeader(const char *begin, const char *end)
+/*
+ * Determine the separator and the meaning of the columns from the header.
+ *
+ * in:  begin First character of the line.
+ *      end    End of the line.
+ * out: return False if there is no time column or no value column.
+ */
+{
+    QByteArray line(begin, end - begin);
+    bool values = false;
+
+    // The most frequent candidate is the separator.
+    this->separator = ',';
+    if(line.count(';') > line.count(this->separator))
+        this->separator = ';';
+    if(line.count('\t') > line.count(this->separator))
+        this->separator = '\t';
+
+    QList<QByteArray> names = line.split(this->separator);
+
+    this->time_column = -1;
+    this->column_count = qMin(names.size(), IMPORT_MAX_COLUMNS);
+
+    for(int i = 0; i < this->column_count; i++)
+    {
+        QByteArray name = names[i].trimmed().toLower();
+
+        if(name.startsWith('"') && name.endsWith('"') && name.size() >= 2)
+            name = name.mid(1, name.size() - 2);
+
+        this->column_quantity[i] = -1;
+
+        if(name == "datetime" || name == "time" || name == "timestamp" || name == "date")
+        {
+            this->time_column = i;
+        }
+        else if(name == "temperature")
+        {
+            this->column_quantity[i] = QUANTITY_TEMPERATURE;
+            values = true;
+        }
+        else if(name == "humidity")
+        {
+            this->column_quantity[i] = QUANTITY_HUMIDITY;
+            values = true;
+        }
+        else if(name == "airpressure" || name == "pressure")
+        {
+            this->column_quantity[i] = QUANTITY_AIRPRESSURE;
+            values = true;
+        }
+    }
+
+    if(this->time_column < 0 || !values)
+    {
+        qWarning() << "Import: the header needs a time column and a temperature, humidity or airpressure column:"
+                   << line.trimmed();
+        return false;
+    }
+
+    return true;
+}
+
+void BulkImporter::ParseLine(const char *begin, const char *end)
+/*
+ * Parse a row and add its samples to the chunk. Empty values are skipped,
+ * a row with an invalid time or value is skipped completely.
+ *
+ * in:  begin First character of the line.
+ *      end    End of the line.
+ * out: none
+ */
+{
+    const char *field = begin;
+    bool present[QUANTITY_COUNT] = { false, false, false };
+    float values[QUANTITY_COUNT];
+    bool time_valid = false;
+    bool valid = true;
+    qint64 time = 0;
+
+    if(end > begin && end[-1] == '\r')
+        end--;
+
+    if(begin == end)
+        return;
+
+    this->rows++;
+
+    for(int column = 0; valid; column++)
+    {
+        const char *field_end = (const char *)memchr(field, this->separator, end - field);
+
+        if(field_end == NULL)
+            field_end = end;
+
+        if(column == this->time_column)
+        {
+            time_valid = ParseTime(field, field_end, &time);
+        }
+        else if(column < this->column_count && this->column_quantity[column] >= 0)
+        {
+            int quantity = this->column_quantity[column];
+            const char *value_begin = field, *value_end = field_end;
+
+            trim_field(&value_begin, &value_end);
+
+            if(value_begin != value_end)
+            {
+                valid = parse_value(value_begin, value_end, &values[quantity]) &&
+                        values[quantity] >= value_limits[quantity][0] &&
+                        values[quantity] <= value_limits[quantity][1];
+                present[quantity] = true;
+            }
+        }
+
+        if(field_end == end)
+            break;
+
+        field = field_end + 1;
+    }
+
+    if(!valid || !time_valid)
+    {
+        this->invalid++;
+
+        if(this->debugmode)
+            qDebug() << "Import: invalid row" << QByteArray(begin, end - begin);
+        return;
+    }
+
+    // DATETIME columns hold whole seconds.
+    time -= time % 1000;
+
+    for(int quantity = 0; quantity < QUANTITY_COUNT; quantity++)
+    {
+        if(!present[quantity])
+            continue;
+
+        StationSample sample;
+        sample.station = 0;
+        sample.time = time;
+        sample.quantity = quantity;
+        sample.value = values[quantity];
+        this->chunk.append(sample);
+    }
+}
+
+bool BulkImporter::ParseTime(const char *begin, const char *end, qint64 *time)
+/*
+ * Parse a time, "yyyy-MM-dd HH:mm[:ss[.zzz]]" in local time or seconds or
+ * msec since epoch.
+ *
+ * in:  begin First character of the field.
+ *      end    End of the field.
+ * out: time   Time (msec since epoch).
+ *      return False if the time is invalid.
+ */
+{
+    trim_field(&begin, &end);
+
+    int length = end - begin;
+
+    if(length == 0)
+        return false;
+
+    if(length <= 15 && all_digits(begin, end))
+    {
+        qint64 epoch = 0;
+
+        for(const char *c = begin; c < end; c++)
+            epoch = epoch * 10 + (*c - '0');
+
+        *time = epoch < EPOCH_MSEC_MIN ? epoch * 1000 : epoch;
+        return true;
+    }
+
+    if(length < 16 || begin[4] != '-' || begin[7] != '-' || (begin[10] != ' ' && begin[10] != 'T') ||
+       begin[13] != ':' || (length > 16 && (length < 19 || begin[16] != ':')) ||
+       (length > 19 && (begin[19] != '.' || !all_digits(begin + 20, end))))
+        return false;
+
+    int year = parse_digits(begin, 4);
+    int month = parse_digits(begin + 5, 2);
+    int day = parse_digits(begin + 8, 2);
+    int hour = parse_digits(begin + 11, 2);
+    int minute = parse_digits(begin + 14, 2);
+    int second = length > 16 ? parse_digits(begin + 17, 2) : 0;
+
+    if(!QDate::isValid(year, month, day) || hour < 0 || hour > 23 || minute < 0 || minute > 59 ||
+       second < 0 || second > 59)
+        return false;
+
+    QDate date(year, month, day);
+    qint64 local = (date.toJulianDay() - EPOCH_JULIAN_DAY) * MSEC_PER_DAY +
+                   (hour * 3600 + minute * 60 + second) * 1000LL;
+
+    // Converting local time is expensive, the offset is determined once
+    // per hour.
+    if(local / MSEC_PER_HOUR != this->cached_hour)
+    {
+        this->cached_hour = local / MSEC_PER_HOUR;
+        this->cached_offset = this->cached_hour * MSEC_PER_HOUR -
+                              QDateTime(date, QTime(hour, 0), Qt::LocalTime).toMSecsSinceEpoch();
+    }
+
+    *time = local - this->cached_offset;
+    return true;
+}
+
+bool BulkImporter::FlushChunk()
+/*
+ * Store the samples of the chunk that are not stored yet in a single
+ * transaction.
+ *
+ * in:  none
+ * out: return False if the database could not be read or written.
+ */
+{
+    QVector<StationSample> accepted;
+    qint64 duplicates = 0;
+
+    if(this->chunk.isEmpty())
+        return true;
+
+    accepted.reserve(this->chunk.size());
+
+    for(int quantity = 0; quantity < QUANTITY_COUNT; quantity++)
+    {
+        qint64 first = LLONG_MAX, last = LLONG_MIN;
+        QSet<qint64> times;
+
+        for(int i = 0; i < this->chunk.size(); i++)
+        {
+            if(this->chunk[i].quantity == quantity)
+            {
+                first = qMin(first, this->chunk[i].time);
+                last = qMax(last, this->chunk[i].time);
+            }
+        }
+
+        if(first > last)
+            continue;
+
+        if(!this->range_read[quantity])
+        {
+            if(!this->weatherdatabase->ReadSampleRange((WeatherQuantity)quantity, &this->range_first[quantity],
+                                                       &this->range_last[quantity]))
+                return false;
+            this->range_read[quantity] = true;
+        }
+
+        if(first <= this->range_last[quantity] && last >= this->range_first[quantity] &&
+           !this->weatherdatabase->ReadSampleTimes((WeatherQuantity)quantity, first, last, &times))
+            return false;
+
+        for(int i = 0; i < this->chunk.size(); i++)
+        {
+            if(this->chunk[i].quantity != quantity)
+                continue;
+
+            if(times.contains(this->chunk[i].time))
+            {
+                duplicates++;
+            }
+            else
+            {
+                times.insert(this->chunk[i].time);
+                accepted.append(this->chunk[i]);
+            }
+        }
+
+        this->range_first[quantity] = qMin(this->range_first[quantity], first);
+        this->range_last[quantity] = qMax(this->range_last[quantity], last);
+    }
+
+    if(!this->weatherdatabase->AddBulkData(accepted))
+    {
+        qWarning() << "Import: unable to store" << accepted.size() << "samples";
+        return false;
+    }
+
+    this->imported += accepted.size();
+    this->duplicates += duplicates;
+    this->chunk.clear();
+
+    return true;
+}
+
+void BulkImporter::Report(const QString &filename, qint64 position, qint64 size)
+/*
+ * Report the progress and the throughput.
+ */
+{
+    double seconds = this->clock.elapsed() / 1000.0;
+
+    qDebug() << "Import" << filename << ":" << (size > 0 ? position * 100 / size : 100) << "%,"
+             << this->rows << "rows," << this->imported << "samples imported,"
+             << this->duplicates << "duplicates," << this->invalid << "invalid,"
+             << (seconds > 0 ? (qint64)(this->rows / seconds * 60) : 0) << "rows per minute";
+}
+
+static void trim_field(const char **begin, const char **end)
+/*
+ * Remove surrounding spaces and quotes from a field.
+ */
+{
+    while(*begin < *end && **begin == ' ')
+        (*begin)++;
+    while(*end > *begin && (*end)[-1] == ' ')
+        (*end)--;
+
+    if(*end - *begin >= 2 && **begin == '"' && (*end)[-1] == '"')
+    {
+        (*begin)++;
+        (*end)--;
+    }
+}
+
+static bool parse_value(const char *begin, const char *end, float *value)
+/*
+ * Parse a decimal number, e.g. "-12.5".
+ */
+{
+    bool negative = false;
+    bool digits = false;
+    double result = 0;
+    double scale = 1;
+
+    if(begin < end && (*begin == '-' || *begin == '+'))
+        negative = *begin++ == '-';
+
+    while(begin < end && *begin >= '0' && *begin <= '9')
+    {
+        result = result * 10 + (*begin++ - '0');
+        digits = true;
+    }
+
+    if(begin < end && *begin == '.')
+    {
+        begin++;
+        while(begin < end && *begin >= '0' && *begin <= '9')
+        {
+            scale /= 10;
+            result += (*begin++ - '0') * scale;
+            digits = true;
+        }
+    }
+
+    if(begin != end || !digits)
+        return false;
+
+    *value = negative ? -result : result;
+    return true;
+}
+
+static int parse_digits(const char *begin, int count)
+/*
+ * Parse count decimal digits, -1 if they are not all digits.
+ */
+{
+    int result = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        if(begin[i] < '0' || begin[i] > '9')
+            return -1;
+        result = result * 10 + (begin[i] - '0');
+    }
+
+    return result;
+}
+
+static bool all_digits(const char *begin, const char *end)
+/*
+ * Whether a field only holds decimal digits.
+ */
+{
+    for(const char *c = begin; c < end; c++)
+        if(*c < '0' || *c > '9')
+            return false;
+
+    return true;
+}
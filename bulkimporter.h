@@ -0,0 +1,78 @@
+#ifndef BULKIMPORTER_H
+#define BULKIMPORTER_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class imports readings from CSV dumps and logger files
+ *              into the weatherdatabase, e.g. to migrate a station or to
+ *              backfill an outage.
+ *
+ *              The first line names the columns. One column holds the time,
+ *              named datetime, time, timestamp or date, either as
+ *              "yyyy-MM-dd HH:mm:ss" (local time) or as seconds or msec
+ *              since epoch. The columns temperature, humidity and
+ *              airpressure (or pressure) hold the values, other columns are
+ *              ignored. The separator (, ; or tab) is taken from the first
+ *              line.
+ */
+
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+#include <weatherdatabase.h>
+
+#define IMPORT_MAP_SIZE         (64 * 1024 * 1024)  // bytes of the file mapped at once
+#define IMPORT_CHUNK_ROWS       (50000)             // samples per transaction
+#define IMPORT_MAX_COLUMNS      (64)
+#define IMPORT_REPORT_INTERVAL  (2000)              // msec
+
+class BulkImporter
+{
+public:
+    BulkImporter(WeatherDatabase *weatherdatabase, bool debugmode);
+
+    bool ImportFile(const QString &filename);
+
+    qint64 Rows() const;
+    qint64 Imported() const;
+    qint64 Duplicates() const;
+    qint64 Invalid() const;
+
+private:
+    bool ReadFile(const QString &filename);
+    bool ParseHeader(const char *begin, const char *end);
+    void ParseLine(const char *begin, const char *end);
+    bool ParseTime(const char *begin, const char *end, qint64 *time);
+    bool FlushChunk();
+    void Report(const QString &filename, qint64 position, qint64 size);
+
+    WeatherDatabase *weatherdatabase;
+    bool debugmode;
+
+    // Layout of the file being imported
+    char separator;
+    int time_column;
+    int column_count;
+    int column_quantity[IMPORT_MAX_COLUMNS];    // WeatherQuantity, -1 to ignore
+
+    QVector<StationSample> chunk;
+
+    // Time range of the stored samples per quantity, including the samples
+    // imported so far. Only chunks overlapping it are checked for duplicates.
+    bool range_read[QUANTITY_COUNT];
+    qint64 range_first[QUANTITY_COUNT];
+    qint64 range_last[QUANTITY_COUNT];
+
+    // Offset of local time to UTC for the hour parsed last
+    qint64 cached_hour;
+    qint64 cached_offset;
+
+    qint64 rows;
+    qint64 imported;
+    qint64 duplicates;
+    qint64 invalid;
+    QElapsedTimer clock;
+    QElapsedTimer report_clock;
+};
+
+#endif // BULKIMPORTER_H
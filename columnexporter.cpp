@@ -0,0 +1,534 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class exports the history of the station to a columnar
+ *              file, see columnexporter.h for the layout.
+ *
+ *              Only the tables of the exported quantities are read, and the
+ *              time range is part of every query, so on the partitioned
+ *              tables only the partitions of the range are touched. The
+ *              range is read one EXPORT_QUERY_SPAN at a time and written as
+ *              soon as a row group is full, which bounds the memory use no
+ *              matter how long the exported range is.
+ *              Time series compress well in columns: consecutive times
+ *              differ by about the same delta and consecutive values share
+ *              their sign, exponent and high mantissa bytes, which end up
+ *              next to each other once the bytes are split into streams.
+ *              The export warns when the range reaches back to samples the
+ *              retention manager has expired to hourly rollups.
+ */
+
+#include "columnexporter.h"
+#include <QSaveFile>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <QDebug>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+static const char *quantity_names[QUANTITY_COUNT] = { "temperature", "humidity", "airpressure" };
+
+static QByteArray encode_times(const QVector<qint64> &times);
+static bool decode_times(const QByteArray &data, int rows, QVector<qint64> *times);
+static QByteArray encode_values(const QVector<float> &values);
+static bool decode_values(const QByteArray &data, int rows, QVector<float> *values);
+
+ColumnExporter::ColumnExporter(WeatherDatabase *weatherdatabase, bool debugmode)
+/*
+ * Constructor.
+ *
+ * in:  weatherdatabase Opened database to export from.
+ *      debugmode       Report every row group that is written.
+ * out: none
+ */
+{
+    this->weatherdatabase = weatherdatabase;
+    this->debugmode = debugmode;
+    this->offset = 0;
+    this->rows = 0;
+    this->bytes = 0;
+}
+
+bool ColumnExporter::Export(const QString &filename, qint64 from, qint64 to, const QVector<WeatherQuantity> &quantities)
+/*
+ * Export the samples of a time range.
+ *
+ * in:  filename   File to write, it is replaced once the export succeeded.
+ *      from       Start of the range (msec since epoch).
+ *      to         End of the range, exclusive (msec since epoch).
+ *      quantities Quantities to export, one time and value column each.
+ * out: return     False if the database could not be read or the file
+ *                 could not be written. An empty range is not an error.
+ */
+{
+    QSaveFile file(filename);
+    QJsonArray row_groups;
+    QJsonArray columns;
+    QElapsedTimer timer;
+    qint64 first = LLONG_MAX, last = LLONG_MIN;
+    int buffered = 0;
+
+    timer.start();
+
+    this->quantities = quantities;
+    this->rows = 0;
+    this->bytes = 0;
+
+    // Only the part of the range that holds samples is read.
+    foreach(WeatherQuantity quantity, quantities)
+    {
+        qint64 quantity_first, quantity_last;
+        qint64 rollup_first, rollup_last;
+
+        if(!this->weatherdatabase->ReadSampleRange(quantity, &quantity_first, &quantity_last) ||
+           !this->weatherdatabase->ReadRollupRange(quantity, &rollup_first, &rollup_last))
+        {
+            qWarning() << "Export: unable to read the range of" << quantity_names[quantity];
+            return false;
+        }
+
+        // Hours older than the oldest raw sample only exist as rollups.
+        if(rollup_first < quantity_first && rollup_first < to && rollup_last >= from)
+            qWarning() << "Export:" << quantity_names[quantity] << "from"
+                       << QDateTime::fromMSecsSinceEpoch(rollup_first).toString(Qt::ISODate) << "to"
+                       << QDateTime::fromMSecsSinceEpoch(rollup_last).toString(Qt::ISODate)
+                       << "has expired to hourly rollups, which are not exported";
+
+        first = qMin(first, quantity_first);
+        last = qMax(last, quantity_last);
+
+        this->times[quantity].resize(0);
+        this->values[quantity].resize(0);
+        columns.append(quantity_names[quantity]);
+    }
+
+    if(first <= last)
+    {
+        from = qMax(from, first);
+        to = qMin(to, last + 1);
+    }
+    else
+    {
+        to = from;
+    }
+
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Export: unable to open" << filename << ":" << file.errorString();
+        return false;
+    }
+
+    file.write(COLUMNFILE_MAGIC, COLUMNFILE_MAGIC_SIZE);
+    this->offset = COLUMNFILE_MAGIC_SIZE;
+
+    for(qint64 start = from; start < to; start += EXPORT_QUERY_SPAN)
+    {
+        qint64 end = qMin(to, start + EXPORT_QUERY_SPAN);
+
+        buffered = 0;
+
+        foreach(WeatherQuantity quantity, quantities)
+        {
+            if(!this->weatherdatabase->ReadSamples(quantity, start, end, &this->times[quantity], &this->values[quantity]))
+            {
+                file.cancelWriting();
+                return false;
+            }
+            buffered += this->times[quantity].size();
+        }
+
+        if(buffered >= EXPORT_ROW_GROUP_ROWS)
+        {
+            row_groups.append(WriteRowGroup(&file));
+            buffered = 0;
+        }
+    }
+
+    if(buffered > 0)
+        row_groups.append(WriteRowGroup(&file));
+
+    QJsonObject metadata;
+    metadata["version"] = COLUMNFILE_VERSION;
+    metadata["from"] = (double)from;
+    metadata["to"] = (double)to;
+    metadata["columns"] = columns;
+    metadata["rows"] = (double)this->rows;
+    metadata["row_groups"] = row_groups;
+
+    QByteArray footer = QJsonDocument(metadata).toJson(QJsonDocument::Compact);
+    uchar length[4];
+    qToLittleEndian<quint32>(footer.size(), length);
+
+    file.write(footer);
+    file.write((const char *)length, sizeof(length));
+    file.write(COLUMNFILE_MAGIC, COLUMNFILE_MAGIC_SIZE);
+
+    if(!file.commit())
+    {
+        qWarning() << "Export: unable to write" << filename << ":" << file.errorString();
+        return false;
+    }
+
+    this->bytes = this->offset + footer.size() + sizeof(length) + COLUMNFILE_MAGIC_SIZE;
+
+    qDebug() << "Export" << filename << ":" << this->rows << "rows," << row_groups.size() << "row groups,"
+             << this->bytes << "bytes in" << timer.elapsed() << "msec";
+
+    return true;
+}
+
+qint64 ColumnExporter::Rows() const
+/*
+ * Number of rows (samples) written by the last export.
+ */
+{
+    return this->rows;
+}
+
+qint64 ColumnExporter::Bytes() const
+/*
+ * Size of the file written by the last export.
+ */
+{
+    return this->bytes;
+}
+
+bool ColumnExporter::ReadFile(const QString &filename, QVector<StationSample> *samples)
+/*
+ * Read all samples of a file written by Export(), e.g. to verify an export.
+ * Only the footer and one column chunk at a time are held in memory.
+ *
+ * in:  filename File to read.
+ * out: samples  Samples of the file are appended, the station is 0.
+ *      return   False if the file is not a valid export.
+ */
+{
+    QFile file(filename);
+    char magic[COLUMNFILE_MAGIC_SIZE];
+    uchar length_data[sizeof(quint32)];
+    qint64 trailer = sizeof(length_data) + COLUMNFILE_MAGIC_SIZE;
+
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 size = file.size();
+
+    if(size < COLUMNFILE_MAGIC_SIZE + trailer ||
+       file.read(magic, COLUMNFILE_MAGIC_SIZE) != COLUMNFILE_MAGIC_SIZE ||
+       memcmp(magic, COLUMNFILE_MAGIC, COLUMNFILE_MAGIC_SIZE) != 0)
+        return false;
+
+    // The trailer: footer length and magic.
+    if(!file.seek(size - trailer) ||
+       file.read((char *)length_data, sizeof(length_data)) != sizeof(length_data) ||
+       file.read(magic, COLUMNFILE_MAGIC_SIZE) != COLUMNFILE_MAGIC_SIZE ||
+       memcmp(magic, COLUMNFILE_MAGIC, COLUMNFILE_MAGIC_SIZE) != 0)
+        return false;
+
+    qint64 length = qFromLittleEndian<quint32>(length_data);
+    qint64 footer_offset = size - trailer - length;
+
+    if(footer_offset < COLUMNFILE_MAGIC_SIZE || !file.seek(footer_offset))
+        return false;
+
+    QJsonObject metadata = QJsonDocument::fromJson(file.read(length)).object();
+
+    if(metadata["version"].toInt() != COLUMNFILE_VERSION)
+        return false;
+
+    foreach(const QJsonValue &group, metadata["row_groups"].toArray())
+    {
+        foreach(const QJsonValue &value, group.toObject()["columns"].toArray())
+        {
+            QJsonObject column = value.toObject();
+            double rows_value = column["rows"].toDouble(-1);
+            qint64 time_size = (qint64)column["time"].toObject()["size"].toDouble(-1);
+            qint64 value_size = (qint64)column["value"].toObject()["size"].toDouble(-1);
+            WeatherQuantity quantity;
+            QByteArray time_data, value_data;
+            QVector<qint64> times;
+            QVector<float> values;
+
+            // Every time takes at least one byte and every value four, so the
+            // sizes of the chunks bound the number of rows.
+            if(rows_value < 0 || rows_value > INT_MAX || rows_value != floor(rows_value) ||
+               rows_value > time_size || (qint64)rows_value * 4 != value_size)
+                return false;
+
+            int rows = (int)rows_value;
+
+            if(!ParseQuantity(column["name"].toString(), &quantity) ||
+               !ReadColumn(&file, footer_offset, column["time"].toObject(), &time_data) ||
+               !ReadColumn(&file, footer_offset, column["value"].toObject(), &value_data))
+                return false;
+
+            if(!decode_times(time_data, rows, &times) || !decode_values(value_data, rows, &values))
+                return false;
+
+            for(int i = 0; i < rows; i++)
+            {
+                StationSample sample;
+                sample.station = 0;
+                sample.time = times[i];
+                sample.quantity = quantity;
+                sample.value = values[i];
+                samples->append(sample);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ColumnExporter::ParseQuantity(const QString &name, WeatherQuantity *quantity)
+/*
+ * Quantity of a column name, e.g. "temperature".
+ *
+ * in:  name     Name of the column.
+ * out: quantity Quantity of the column.
+ *      return   False if the name is unknown.
+ */
+{
+    for(int i = 0; i < QUANTITY_COUNT; i++)
+    {
+        if(name == quantity_names[i])
+        {
+            *quantity = (WeatherQuantity)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QJsonObject ColumnExporter::WriteRowGroup(QIODevice *file)
+/*
+ * Write the buffered samples as a row group.
+ *
+ * in:  file   File to write to.
+ * out: return Description of the row group for the footer.
+ */
+{
+    QJsonObject group;
+    QJsonArray columns;
+    qint64 group_rows = 0;
+
+    foreach(WeatherQuantity quantity, this->quantities)
+    {
+        const QVector<qint64> &times = this->times[quantity];
+        const QVector<float> &values = this->values[quantity];
+        QJsonObject column;
+
+        if(times.isEmpty())
+            continue;
+
+        float minimum = values[0], maximum = values[0];
+        for(int i = 1; i < values.size(); i++)
+        {
+            minimum = qMin(minimum, values[i]);
+            maximum = qMax(maximum, values[i]);
+        }
+
+        // The samples are ordered by time.
+        QJsonObject time_chunk = WriteColumn(file, encode_times(times), "delta_zigzag_varint");
+        time_chunk["min"] = (double)times.first();
+        time_chunk["max"] = (double)times.last();
+
+        QJsonObject value_chunk = WriteColumn(file, encode_values(values), "byte_stream_split_float32");
+        value_chunk["min"] = minimum;
+        value_chunk["max"] = maximum;
+
+        column["name"] = quantity_names[quantity];
+        column["rows"] = times.size();
+        column["time"] = time_chunk;
+        column["value"] = value_chunk;
+        columns.append(column);
+
+        group_rows += times.size();
+
+        this->times[quantity].resize(0);
+        this->values[quantity].resize(0);
+    }
+
+    this->rows += group_rows;
+
+    group["rows"] = (double)group_rows;
+    group["columns"] = columns;
+
+    if(this->debugmode)
+        qDebug() << "Export: row group of" << group_rows << "rows written," << this->offset << "bytes";
+
+    return group;
+}
+
+QJsonObject ColumnExporter::WriteColumn(QIODevice *file, const QByteArray &data, const char *encoding)
+/*
+ * Compress and write a column chunk.
+ *
+ * in:  file     File to write to.
+ *      data     Encoded column.
+ *      encoding Name of the encoding.
+ * out: return   Description of the column chunk for the footer.
+ */
+{
+    QByteArray compressed = qCompress(data, EXPORT_COMPRESSION);
+    QJsonObject chunk;
+
+    file->write(compressed);
+
+    chunk["offset"] = (double)this->offset;
+    chunk["size"] = data.size();
+    chunk["compressed_size"] = compressed.size();
+    chunk["encoding"] = encoding;
+    chunk["compression"] = "qcompress";
+
+    this->offset += compressed.size();
+
+    return chunk;
+}
+
+bool ColumnExporter::ReadColumn(QIODevice *file, qint64 end, const QJsonObject &chunk, QByteArray *data)
+/*
+ * Read and uncompress a column chunk written by WriteColumn().
+ *
+ * in:  file   File to read from.
+ *      end    Offset of the footer, chunks end before it.
+ *      chunk  Description of the column chunk from the footer.
+ * out: data   Encoded column.
+ *      return False if the chunk is outside of the file or corrupt.
+ */
+{
+    // JSON numbers are doubles, offsets beyond 2 GB do not fit an int.
+    qint64 offset = (qint64)chunk["offset"].toDouble();
+    qint64 size = (qint64)chunk["compressed_size"].toDouble();
+
+    if(offset < COLUMNFILE_MAGIC_SIZE || size < 0 || offset + size > end || !file->seek(offset))
+        return false;
+
+    QByteArray compressed = file->read(size);
+    qint64 expected = (qint64)chunk["size"].toDouble(-1);
+
+    // qCompress() prefixes the size of the data (big endian), which
+    // qUncompress() allocates up front. zlib expands by at most 1032:1.
+    if(compressed.size() != size || size < 4 || expected < 0 || expected > size * 1032 ||
+       qFromBigEndian<quint32>((const uchar *)compressed.constData()) != (quint64)expected)
+        return false;
+
+    *data = qUncompress(compressed);
+
+    return data->size() == expected;
+}
+
+static QByteArray encode_times(const QVector<qint64> &times)
+/*
+ * Encode the difference with the previous time (the first time itself) as
+ * zigzag varints, 7 bits per byte.
+ */
+{
+    QByteArray data;
+    qint64 previous = 0;
+
+    data.reserve(times.size() * 3 + 8);
+
+    for(int i = 0; i < times.size(); i++)
+    {
+        qint64 delta = times[i] - previous;
+        quint64 zigzag = ((quint64)delta << 1) ^ (quint64)(delta >> 63);
+
+        while(zigzag >= 0x80)
+        {
+            data.append((char)(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        data.append((char)zigzag);
+
+        previous = times[i];
+    }
+
+    return data;
+}
+
+static bool decode_times(const QByteArray &data, int rows, QVector<qint64> *times)
+/*
+ * Decode a column encoded by encode_times().
+ */
+{
+    const uchar *c = (const uchar *)data.constData();
+    const uchar *end = c + data.size();
+    qint64 previous = 0;
+
+    if(rows < 0 || rows > data.size())
+        return false;
+
+    times->resize(rows);
+
+    for(int i = 0; i < rows; i++)
+    {
+        quint64 zigzag = 0;
+        int shift = 0;
+
+        do
+        {
+            if(c == end || shift > 63)
+                return false;
+            zigzag |= (quint64)(*c & 0x7F) << shift;
+            shift += 7;
+        }
+        while(*c++ & 0x80);
+
+        previous += (qint64)(zigzag >> 1) ^ -(qint64)(zigzag & 1);
+        (*times)[i] = previous;
+    }
+
+    return c == end;
+}
+
+static QByteArray encode_values(const QVector<float> &values)
+/*
+ * Store byte k of every value (little endian) in stream k.
+ */
+{
+    int rows = values.size();
+    QByteArray data(rows * 4, 0);
+    char *c = data.data();
+
+    for(int i = 0; i < rows; i++)
+    {
+        quint32 bits;
+        memcpy(&bits, &values[i], sizeof(bits));
+
+        for(int k = 0; k < 4; k++)
+            c[k * rows + i] = (char)(bits >> (k * 8));
+    }
+
+    return data;
+}
+
+static bool decode_values(const QByteArray &data, int rows, QVector<float> *values)
+/*
+ * Decode a column encoded by encode_values().
+ */
+{
+    const uchar *c = (const uchar *)data.constData();
+
+    if(rows < 0 || data.size() != (qint64)rows * 4)
+        return false;
+
+    values->resize(rows);
+
+    for(int i = 0; i < rows; i++)
+    {
+        quint32 bits = 0;
+
+        for(int k = 0; k < 4; k++)
+            bits |= (quint32)c[k * rows + i] << (k * 8);
+
+        memcpy(&(*values)[i], &bits, sizeof(bits));
+    }
+
+    return true;
+}
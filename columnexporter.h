@@ -0,0 +1,70 @@
+#ifndef COLUMNEXPORTER_H
+#define COLUMNEXPORTER_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class exports the history of the station to a columnar
+ *              file. The file is made up of row groups, each holding a time
+ *              and a value column per exported quantity:
+ *
+ *                  "WSCOL1\0\0"
+ *                  column chunks of row group 1
+ *                  ...
+ *                  column chunks of row group n
+ *                  footer (JSON)
+ *                  footer length (uint32, little endian)
+ *                  "WSCOL1\0\0"
+ *
+ *              The footer describes the row groups and for every column
+ *              chunk its offset, size, encoding and minimum and maximum.
+ *              Times are msec since epoch, delta encoded as zigzag varints.
+ *              Values are float32 little endian with the bytes of the values
+ *              split into four streams. Both are compressed with qCompress.
+ *
+ *              Only the raw samples are exported, not the hourly rollups
+ *              that remain once the raw samples have expired.
+ */
+
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <weatherdatabase.h>
+
+#define COLUMNFILE_MAGIC        "WSCOL1\0\0"
+#define COLUMNFILE_MAGIC_SIZE   (8)
+#define COLUMNFILE_VERSION      (1)
+#define EXPORT_QUERY_SPAN       (24 * 3600 * 1000LL)    // msec read from the database per query
+#define EXPORT_ROW_GROUP_ROWS   (65536)                 // rows after which a row group is written
+#define EXPORT_COMPRESSION      (6)                     // zlib level
+
+class ColumnExporter
+{
+public:
+    ColumnExporter(WeatherDatabase *weatherdatabase, bool debugmode);
+
+    bool Export(const QString &filename, qint64 from, qint64 to, const QVector<WeatherQuantity> &quantities);
+
+    qint64 Rows() const;
+    qint64 Bytes() const;
+
+    static bool ReadFile(const QString &filename, QVector<StationSample> *samples);
+    static bool ParseQuantity(const QString &name, WeatherQuantity *quantity);
+
+private:
+    QJsonObject WriteRowGroup(QIODevice *file);
+    QJsonObject WriteColumn(QIODevice *file, const QByteArray &data, const char *encoding);
+    static bool ReadColumn(QIODevice *file, qint64 end, const QJsonObject &chunk, QByteArray *data);
+
+    WeatherDatabase *weatherdatabase;
+    bool debugmode;
+
+    QVector<WeatherQuantity> quantities;
+    QVector<qint64> times[QUANTITY_COUNT];
+    QVector<float> values[QUANTITY_COUNT];
+    qint64 offset;
+
+    qint64 rows;
+    qint64 bytes;
+};
+
+#endif // COLUMNEXPORTER_H
@@ -61,9 +61,6 @@ bool DHT22Sensor::readDHT(int pin, float *temperature, float *humidity)
  */
 {
     QLinkedList<long> high_pulse_duration_lst;
-    long duration = 0;
-    int data[10];
-    int j=0;
     bool success = false;
 
     if(this->sensor_initialized)
@@ -83,54 +80,73 @@ bool DHT22Sensor::readDHT(int pin, float *temperature, float *humidity)
         // the high level pulses send by the sensor.
         detect_high_pulses_duration(pin, &high_pulse_duration_lst);
 
-        // Set sensor data array to zero.
-        data[0] = data[1] = data[2] = data[3] = data[4] = 0;
+        success = DecodePulses(high_pulse_duration_lst, temperature, humidity);
+    }
 
-        // The first 2 high pulses consist of the host start signal
-        // and sensor response signals and need to be stripped
-        // from the linked list.
-        if(!high_pulse_duration_lst.empty())
-        {
-            high_pulse_duration_lst.pop_front();
-            high_pulse_duration_lst.pop_front();
-        }
+    return success;
+}
 
-        foreach(duration, high_pulse_duration_lst)
-        {
-            // shove each bit into the storage bytes
-            data[j/8] <<= 1;
-            // duration > 50 usec indicates a "1"
-            // (from spec: "0" = 26-28 us, "1" = ~70 us)
-            if ((duration / 1000) > 50)
-              data[j/8] |= 1;
-            j++;
-        }
+bool DHT22Sensor::DecodePulses(const QLinkedList<long> &high_pulse_duration_lst, float *temperature, float *humidity)
+/*
+ * Decode the temperature and humidity from the duration of the high level
+ * pulses send by the sensor. Separated from readDHT() so recorded traces can
+ * be decoded without the sensor.
+ *
+ * in:  high_pulse_duration_lst Duration of all high level pulses (nsec),
+ *                              including the start and response signals.
+ * out: temperature             Temperature that is read back (degrees celcius)
+ *      humidity                Humdity that is read back (relative (%))
+ *      return                  True if the checksum is valid.
+ */
+{
+    QLinkedList<long>::const_iterator it = high_pulse_duration_lst.constBegin();
+    int data[10];
+    int j=0;
+    bool success = false;
 
-        // Verify checksum
-        if(data[4] == ((data[0] + data[1] + data[2] + data[3]) & 0xFF))
-        {
-            success = true;
+    // Set sensor data array to zero.
+    data[0] = data[1] = data[2] = data[3] = data[4] = 0;
+
+    // The first 2 high pulses consist of the host start signal
+    // and sensor response signals and need to be skipped.
+    for(int i = 0; i < 2 && it != high_pulse_duration_lst.constEnd(); i++)
+        ++it;
 
-            // First 16 bits contain the humidity
-            *humidity = data[0] * 256 + data[1];
+    for(; it != high_pulse_duration_lst.constEnd() && j < 40; ++it)
+    {
+        // shove each bit into the storage bytes
+        data[j/8] <<= 1;
+        // duration > 50 usec indicates a "1"
+        // (from spec: "0" = 26-28 us, "1" = ~70 us)
+        if ((*it / 1000) > 50)
+          data[j/8] |= 1;
+        j++;
+    }
+
+    // Verify checksum
+    if(j == 40 && data[4] == ((data[0] + data[1] + data[2] + data[3]) & 0xFF))
+    {
+        success = true;
 
-            // Decimal output looks like e.g. 323 --> 32,3%
-            // So divide by 10
-            *humidity /= 10;
+        // First 16 bits contain the humidity
+        *humidity = data[0] * 256 + data[1];
 
-            // bits 16-32 contain the temperature
-            // Mask bit 7 of the first 8 bits, because it is
-            // the signed bit for negative/positive temperature
-            *temperature = (data[2] & 0x7F) * 256 + data[3];
+        // Decimal output looks like e.g. 323 --> 32,3%
+        // So divide by 10
+        *humidity /= 10;
 
-            // Decimal output looks like e.g. 253 --> 25,3 degrees celcius
-            // So divide by 10
-            *temperature /= 10.0;
+        // bits 16-32 contain the temperature
+        // Mask bit 7 of the first 8 bits, because it is
+        // the signed bit for negative/positive temperature
+        *temperature = (data[2] & 0x7F) * 256 + data[3];
 
-            // Read bit 7 to verify if the temperature is negative/positive.
-            if (data[2] & 0x80)
-                *temperature *= -1;
-        }
+        // Decimal output looks like e.g. 253 --> 25,3 degrees celcius
+        // So divide by 10
+        *temperature /= 10.0;
+
+        // Read bit 7 to verify if the temperature is negative/positive.
+        if (data[2] & 0x80)
+            *temperature *= -1;
     }
 
     return success;
@@ -28,6 +28,8 @@ public:
     void CloseSensor();
     bool readDHT(int pin, float *temperature, float *humidity);
 
+    static bool DecodePulses(const QLinkedList<long> &high_pulse_duration_lst, float *temperature, float *humidity);
+
 private:
     bool sensor_initialized;
 };
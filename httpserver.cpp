@@ -0,0 +1,402 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class offers a small HTTP/JSON interface to the live
+ *              weather data. It runs on the event loop of its own thread:
+ *                  /latest             latest reading
+ *                  /range?from=&to=    readings from the in-memory history
+ *                  /analytics          latest derived signals and alerts
+ *                  /events             server-sent events stream of readings,
+ *                                      derived signals and alerts
+ *                  /image.jpg          latest picture
+ *              Every reading is serialized once, the resulting buffers are
+ *              implicitly shared by all responses. The picture is the buffer
+ *              read at capture time, it is never copied or re-encoded.
+ */
+
+#include "httpserver.h"
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QDebug>
+#include <algorithm>
+
+static QJsonObject reading_to_json(const WeatherReading &reading);
+static QByteArray http_header(const char *status, const char *content_type, int content_length, bool keep_alive);
+static QByteArray http_response(const char *status, const char *content_type, const QByteArray &body, bool keep_alive);
+static qint64 parse_time(const QString &value, qint64 fallback);
+static bool reading_before(const WeatherReading &reading, qint64 time);
+
+HttpServer::HttpServer(const QHostAddress &address, quint16 port, bool debugmode)
+/*
+ * Constructor. The server starts listening once Start() is called from the
+ * thread it has been moved to.
+ *
+ * in:  address   Address to listen on, e.g. QHostAddress::LocalHost.
+ *      port      TCP port to listen on, 0 picks a free port (see Port()).
+ *      debugmode Print the fan-out time of each reading.
+ * out: none
+ */
+{
+    qRegisterMetaType<WeatherReading>();
+
+    this->server = NULL;
+    this->address = address;
+    this->port = port;
+    this->debugmode = debugmode;
+
+    for(int keep_alive = 0; keep_alive < 2; keep_alive++)
+    {
+        this->latest_response[keep_alive] = http_response("404 Not Found", "text/plain", "No reading yet\n", keep_alive);
+        this->analytics_response[keep_alive] = this->latest_response[keep_alive];
+        this->image_header[keep_alive] = http_header("404 Not Found", "text/plain", 0, keep_alive);
+    }
+}
+
+void HttpServer::Start()
+/*
+ * Start listening for connections.
+ *
+ * in:  none
+ * out: none
+ */
+{
+    this->server = new QTcpServer(this);
+
+    connect(this->server, SIGNAL(newConnection()), this, SLOT(NewConnection()));
+
+    if(!this->server->listen(this->address, this->port))
+    {
+        qWarning() << "HTTP server: unable to listen on" << this->address.toString() << "port" << this->port
+                   << ":" << this->server->errorString();
+        return;
+    }
+
+    this->port = this->server->serverPort();
+
+    if(this->debugmode)
+        qDebug() << "HTTP server: listening on" << this->address.toString() << "port" << this->port;
+}
+
+quint16 HttpServer::Port() const
+/*
+ * TCP port the server listens on, valid once Start() returned.
+ */
+{
+    return this->port;
+}
+
+void HttpServer::PublishReading(const WeatherReading &reading, const QByteArray &image)
+/*
+ * Make a new reading available. The responses are serialized once here and
+ * the event is pushed to all subscribers.
+ *
+ * in:  reading Latest reading.
+ *      image   Latest picture (JPEG), may be empty.
+ * out: none
+ */
+{
+    QElapsedTimer timer;
+    QByteArray json = QJsonDocument(reading_to_json(reading)).toJson(QJsonDocument::Compact);
+
+    timer.start();
+
+    this->history.append(reading);
+    if(this->history.size() > HTTP_HISTORY_SIZE)
+        this->history.removeFirst();
+
+    // The responses only differ in the Connection header.
+    this->latest_response[true] = http_response("200 OK", "application/json", json, true);
+    this->latest_response[false] = http_response("200 OK", "application/json", json, false);
+    this->latest_event = "event: reading\ndata: " + json + "\n\n";
+
+    if(!image.isEmpty())
+    {
+        this->image = image;
+        this->image_header[true] = http_header("200 OK", "image/jpeg", image.size(), true);
+        this->image_header[false] = http_header("200 OK", "image/jpeg", image.size(), false);
+    }
+
+    Broadcast(this->latest_event);
+
+    if(this->debugmode)
+        qDebug() << "HTTP server: reading pushed to" << this->subscribers.size()
+                 << "subscribers in" << timer.nsecsElapsed() / 1000 << "usec";
+}
+
+void HttpServer::PublishAnalytics(const QByteArray &json)
+/*
+ * Make the latest derived signals available and push them to all
+ * subscribers.
+ *
+ * in:  json Derived signals (see StreamAnalytics::ToJson()).
+ * out: none
+ */
+{
+    this->analytics_response[true] = http_response("200 OK", "application/json", json, true);
+    this->analytics_response[false] = http_response("200 OK", "application/json", json, false);
+
+    Broadcast("event: analytics\ndata: " + json + "\n\n");
+}
+
+void HttpServer::PublishAlert(const QByteArray &json)
+/*
+ * Push an alert that was raised or cleared to all subscribers.
+ *
+ * in:  json Alert (see StreamAnalytics::AlertToJson()).
+ * out: none
+ */
+{
+    Broadcast("event: alert\ndata: " + json + "\n\n");
+}
+
+void HttpServer::NewConnection()
+/*
+ * Accept the pending connections.
+ */
+{
+    while(this->server->hasPendingConnections())
+    {
+        QTcpSocket *socket = this->server->nextPendingConnection();
+
+        connect(socket, SIGNAL(readyRead()), this, SLOT(ReadRequest()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(Disconnected()));
+
+        this->requests.insert(socket, QByteArray());
+    }
+}
+
+void HttpServer::ReadRequest()
+/*
+ * Collect request data and handle every complete request. Only the request
+ * line and the Connection header are of interest, request bodies are not
+ * supported.
+ */
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+
+    if(socket == NULL || !this->requests.contains(socket))
+        return;
+
+    // Work on a copy, handling a request may close and forget the connection.
+    QByteArray buffer = this->requests.value(socket) + socket->readAll();
+
+    int end;
+    while((end = buffer.indexOf("\r\n\r\n")) != -1)
+    {
+        QByteArray header = buffer.left(end);
+        buffer.remove(0, end + 4);
+
+        QList<QByteArray> lines = header.split('\n');
+        QList<QByteArray> request_line = lines.first().trimmed().split(' ');
+        bool keep_alive = true;
+
+        for(int i = 1; i < lines.size(); i++)
+        {
+            QByteArray line = lines[i].trimmed().toLower();
+            if(line.startsWith("connection:") && line.contains("close"))
+                keep_alive = false;
+        }
+
+        if(request_line.size() < 3)
+        {
+            socket->write(http_response("400 Bad Request", "text/plain", "Bad request\n", false));
+            socket->disconnectFromHost();
+            return;
+        }
+
+        if(request_line[2] == "HTTP/1.0")
+            keep_alive = false;
+
+        HandleRequest(socket, request_line[0], request_line[1], keep_alive);
+
+        if(!keep_alive || this->subscribers.contains(socket))
+        {
+            buffer.clear();
+            break;
+        }
+    }
+
+    if(buffer.size() > HTTP_MAX_REQUEST_SIZE)
+    {
+        socket->write(http_response("431 Request Header Fields Too Large", "text/plain", "Request too large\n", false));
+        socket->disconnectFromHost();
+        buffer.clear();
+    }
+
+    if(this->requests.contains(socket))
+        this->requests.insert(socket, buffer);
+}
+
+void HttpServer::Disconnected()
+/*
+ * Forget a closed connection.
+ */
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+
+    if(socket == NULL)
+        return;
+
+    this->requests.remove(socket);
+    this->subscribers.remove(socket);
+    socket->deleteLater();
+}
+
+void HttpServer::HandleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &target, bool keep_alive)
+/*
+ * Write the response to a request.
+ *
+ * in:  socket     Connection the request was received on.
+ *      method     HTTP method.
+ *      target     Request target (path and query).
+ *      keep_alive Keep the connection open after the response.
+ * out: none
+ */
+{
+    QByteArray path = target.left(target.indexOf('?') == -1 ? target.size() : target.indexOf('?'));
+
+    if(method != "GET")
+        socket->write(http_response("405 Method Not Allowed", "text/plain", "Only GET is supported\n", keep_alive));
+    else if(path == "/latest")
+        socket->write(this->latest_response[keep_alive]);
+    else if(path == "/analytics")
+        socket->write(this->analytics_response[keep_alive]);
+    else if(path == "/range")
+        socket->write(RangeResponse(target, keep_alive));
+    else if(path == "/image.jpg")
+    {
+        socket->write(this->image_header[keep_alive]);
+        socket->write(this->image);
+    }
+    else if(path == "/events")
+    {
+        socket->write("HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/event-stream\r\n"
+                      "Cache-Control: no-cache\r\n"
+                      "Connection: keep-alive\r\n\r\n");
+        if(!this->history.isEmpty())
+            socket->write(this->latest_event);
+        this->subscribers.insert(socket);
+        return;
+    }
+    else
+        socket->write(http_response("404 Not Found", "text/plain", "Not found\n", keep_alive));
+
+    if(!keep_alive)
+        socket->disconnectFromHost();
+}
+
+QByteArray HttpServer::RangeResponse(const QByteArray &target, bool keep_alive)
+/*
+ * Serialize the readings within the requested time range. Times are given
+ * in msec since epoch or as ISO 8601 date and time.
+ *
+ * in:  target     Request target, e.g. /range?from=2026-01-01T00:00:00&to=...
+ *      keep_alive Keep the connection open after the response.
+ * out: return     Complete HTTP response.
+ */
+{
+    QUrlQuery query(QUrl::fromEncoded(target));
+    qint64 from = parse_time(query.queryItemValue("from"), 0);
+    qint64 to = parse_time(query.queryItemValue("to"), Q_INT64_C(0x7FFFFFFFFFFFFFFF));
+    QJsonArray readings;
+
+    // The history is ordered by time, so the start can be looked up.
+    QList<WeatherReading>::const_iterator it =
+            std::lower_bound(this->history.constBegin(), this->history.constEnd(), from, reading_before);
+
+    for(; it != this->history.constEnd() && it->time <= to; ++it)
+        readings.append(reading_to_json(*it));
+
+    return http_response("200 OK", "application/json", QJsonDocument(readings).toJson(QJsonDocument::Compact), keep_alive);
+}
+
+void HttpServer::Broadcast(const QByteArray &event)
+/*
+ * Write an event to all subscribers.
+ */
+{
+    foreach(QTcpSocket *socket, this->subscribers)
+    {
+        // Drop subscribers that do not keep up, instead of buffering without bound.
+        if(socket->bytesToWrite() > HTTP_MAX_PENDING_WRITE)
+            socket->abort();
+        else
+            socket->write(event);
+    }
+}
+
+static QJsonObject reading_to_json(const WeatherReading &reading)
+/*
+ * Convert a reading into a JSON object.
+ */
+{
+    QJsonObject object;
+
+    object["time"] = (double)reading.time;
+    object["count"] = (double)reading.count;
+    object["status"] = (int)reading.status;
+
+    if(reading.status & WEATHER_STATUS_DHT22_VALID)
+    {
+        object["temperature"] = reading.temperature;
+        object["humidity"] = reading.humidity;
+    }
+    object["dht22_time"] = (double)reading.dht22_time;
+
+    if(reading.status & WEATHER_STATUS_BMP085_VALID)
+        object["airpressure"] = reading.airpressure;
+    object["bmp085_time"] = (double)reading.bmp085_time;
+
+    object["image_time"] = (double)reading.image_time;
+
+    return object;
+}
+
+static QByteArray http_header(const char *status, const char *content_type, int content_length, bool keep_alive)
+/*
+ * Build the status line and headers of a response.
+ */
+{
+    return QByteArray("HTTP/1.1 ") + status + "\r\n"
+           "Content-Type: " + content_type + "\r\n"
+           "Content-Length: " + QByteArray::number(content_length) + "\r\n"
+           "Access-Control-Allow-Origin: *\r\n"
+           "Connection: " + (keep_alive ? "keep-alive" : "close") + "\r\n\r\n";
+}
+
+static QByteArray http_response(const char *status, const char *content_type, const QByteArray &body, bool keep_alive)
+/*
+ * Build a complete response.
+ */
+{
+    return http_header(status, content_type, body.size(), keep_alive) + body;
+}
+
+static qint64 parse_time(const QString &value, qint64 fallback)
+/*
+ * Parse a time given in msec since epoch or as ISO 8601 date and time.
+ */
+{
+    bool ok = false;
+    qint64 time = value.toLongLong(&ok);
+
+    if(ok)
+        return time;
+
+    QDateTime datetime = QDateTime::fromString(value, Qt::ISODate);
+
+    return datetime.isValid() ? datetime.toMSecsSinceEpoch() : fallback;
+}
+
+static bool reading_before(const WeatherReading &reading, qint64 time)
+/*
+ * Ordering of the history for std::lower_bound.
+ */
+{
+    return reading.time < time;
+}
@@ -0,0 +1,78 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class offers a small HTTP/JSON interface to the live
+ *              weather data. It runs on the event loop of its own thread:
+ *                  /latest             latest reading
+ *                  /range?from=&to=    readings from the in-memory history
+ *                  /analytics          latest derived signals and alerts
+ *                  /events             server-sent events stream of readings,
+ *                                      derived signals and alerts
+ *                  /image.jpg          latest picture
+ */
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QMetaType>
+#include <weathersharedmemory.h>
+
+#define HTTP_PORT               (0)                 // disabled unless a port is given
+#define HTTP_ADDRESS            "127.0.0.1"         // only local clients unless an address is given
+#define HTTP_HISTORY_SIZE       (7 * 24 * 60)       // readings, a week at one per minute
+#define HTTP_MAX_REQUEST_SIZE   (8 * 1024)          // bytes
+#define HTTP_MAX_PENDING_WRITE  (1024 * 1024)       // bytes, slow subscribers are dropped
+
+Q_DECLARE_METATYPE(WeatherReading)
+
+class HttpServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    HttpServer(const QHostAddress &address, quint16 port, bool debugmode);
+
+    quint16 Port() const;
+
+public slots:
+    void Start();
+    void PublishReading(const WeatherReading &reading, const QByteArray &image);
+    void PublishAnalytics(const QByteArray &json);
+    void PublishAlert(const QByteArray &json);
+
+private slots:
+    void NewConnection();
+    void ReadRequest();
+    void Disconnected();
+
+private:
+    void HandleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &target, bool keep_alive);
+    QByteArray RangeResponse(const QByteArray &target, bool keep_alive);
+    void Broadcast(const QByteArray &event);
+
+    QTcpServer *server;
+    QHostAddress address;
+    quint16 port;
+    bool debugmode;
+
+    QHash<QTcpSocket *, QByteArray> requests;
+    QSet<QTcpSocket *> subscribers;
+    QList<WeatherReading> history;
+
+    // Serialized once per reading and shared by all clients, indexed by
+    // keep_alive so the Connection header matches what the server does.
+    QByteArray latest_response[2];
+    QByteArray latest_event;
+    QByteArray analytics_response[2];
+    QByteArray image_header[2];
+    QByteArray image;
+};
+
+#endif // HTTPSERVER_H
@@ -0,0 +1,275 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class post-processes the captured frames on a pool of
+ *              idle priority worker threads. Each frame is decoded once to
+ *              produce the thumbnail and preview renditions and is appended
+ *              to the timelapse of the day.
+ *              The timelapse is a motion JPEG stream: the captured JPEG
+ *              frames are appended as they are, so past frames are never
+ *              decoded or encoded again. It can be played or converted with
+ *              e.g. "ffmpeg -f mjpeg -i timelapse-20260101.mjpeg".
+ *              Only the timelapses of the last TIMELAPSE_DAYS days are kept.
+ */
+
+#include "imagepipeline.h"
+#include <QRunnable>
+#include <QThread>
+#include <QImage>
+#include <QBuffer>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QMutexLocker>
+
+class ImagePipelineTask : public QRunnable
+{
+public:
+    ImagePipelineTask(ImagePipeline *pipeline, const QByteArray &image, int64_t time, quint64 sequence)
+        : pipeline(pipeline), image(image), time(time), sequence(sequence) {}
+
+    void run()
+    {
+        // Post-processing may never compete with the sensor acquisition.
+        QThread::currentThread()->setPriority(QThread::IdlePriority);
+        pipeline->ProcessFrame(image, time, sequence);
+    }
+
+private:
+    ImagePipeline *pipeline;
+    QByteArray image;
+    int64_t time;
+    quint64 sequence;
+};
+
+ImagePipeline::ImagePipeline(const QString &directory)
+/*
+ * Constructor.
+ *
+ * in:  directory Directory the renditions and timelapses are written to.
+ * out: none
+ */
+{
+    this->directory = directory;
+    this->queued_frames = 0;
+    this->timelapse_sequence = 0;
+    this->rendition_sequence = 0;
+    this->frames = 0;
+    this->processing_time = 0;
+
+    // Leave a core for the acquisition.
+    this->pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+    this->uptime.start();
+}
+
+ImagePipeline::~ImagePipeline()
+/*
+ * Destructor. Waits for the queued frames to be processed.
+ */
+{
+    this->pool.waitForDone();
+}
+
+void ImagePipeline::AddFrame(const QByteArray &image, int64_t time)
+/*
+ * Queue a frame for processing. Returns immediately, the image data is
+ * shared with the worker thread and not copied.
+ *
+ * in:  image JPEG encoded frame.
+ *      time  Time the frame was taken (msec since epoch).
+ * out: none
+ */
+{
+    if(image.isEmpty())
+        return;
+
+    this->pool.start(new ImagePipelineTask(this, image, time, this->queued_frames++));
+}
+
+void ImagePipeline::ProcessFrame(const QByteArray &image, int64_t time, quint64 sequence)
+/*
+ * Decode a frame, write its renditions and append it to the timelapse.
+ *
+ * in:  image    JPEG encoded frame.
+ *      time     Time the frame was taken (msec since epoch).
+ *      sequence Position of the frame in the queue.
+ * out: none
+ */
+{
+    QElapsedTimer timer;
+    QImage frame;
+
+    timer.start();
+
+    if(frame.loadFromData(image, "JPG"))
+    {
+        QImage preview = frame.scaled(PREVIEW_WIDTH, PREVIEW_HEIGHT, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        // The thumbnail is derived from the preview, which is cheaper than from the frame.
+        QImage thumbnail = preview.scaled(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        QByteArray encoded_preview, encoded_thumbnail;
+        QBuffer buffer(&encoded_preview);
+
+        buffer.open(QIODevice::WriteOnly);
+        preview.save(&buffer, "JPG", RENDITION_QUALITY);
+        buffer.close();
+
+        buffer.setBuffer(&encoded_thumbnail);
+        buffer.open(QIODevice::WriteOnly);
+        thumbnail.save(&buffer, "JPG", RENDITION_QUALITY);
+        buffer.close();
+
+        // A worker that finishes after a later frame would replace the
+        // renditions with an older picture, its renditions are stale.
+        QMutexLocker locker(&this->rendition_mutex);
+
+        if(sequence >= this->rendition_sequence)
+        {
+            SaveRendition("image_preview.jpg", encoded_preview);
+            SaveRendition("image_thumbnail.jpg", encoded_thumbnail);
+            this->rendition_sequence = sequence + 1;
+        }
+    }
+
+    AppendTimelapse(image, time, sequence);
+
+    QMutexLocker locker(&this->statistics_mutex);
+    this->frames++;
+    this->processing_time += timer.nsecsElapsed();
+}
+
+void ImagePipeline::WaitForDone()
+/*
+ * Wait until all queued frames have been processed.
+ */
+{
+    this->pool.waitForDone();
+}
+
+long ImagePipeline::Frames() const
+/*
+ * Number of frames processed.
+ */
+{
+    QMutexLocker locker(&this->statistics_mutex);
+    return this->frames;
+}
+
+qint64 ImagePipeline::AverageProcessingTime() const
+/*
+ * Average processing time per frame (nsec).
+ */
+{
+    QMutexLocker locker(&this->statistics_mutex);
+    return this->frames > 0 ? this->processing_time / this->frames : 0;
+}
+
+double ImagePipeline::Utilization() const
+/*
+ * Fraction of the available worker time that was spent processing frames.
+ */
+{
+    QMutexLocker locker(&this->statistics_mutex);
+    qint64 available = this->uptime.nsecsElapsed() * this->pool.maxThreadCount();
+    return available > 0 ? (double)this->processing_time / available : 0.0;
+}
+
+bool ImagePipeline::SaveRendition(const QString &filename, const QByteArray &encoded)
+/*
+ * Replace a rendition atomically, so readers never see a partial file.
+ *
+ * in:  filename Name of the rendition.
+ *      encoded  JPEG encoded rendition.
+ * out: return   True if the rendition was written.
+ */
+{
+    QSaveFile file(QDir(this->directory).filePath(filename));
+
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(encoded);
+
+    return file.commit();
+}
+
+void ImagePipeline::AppendTimelapse(const QByteArray &image, int64_t time, quint64 sequence)
+/*
+ * Append a frame to the timelapse in the order the frames were queued. A
+ * frame finished by a worker before an earlier frame is held back until the
+ * earlier frames have been appended, so no frame is lost.
+ *
+ * in:  image    JPEG encoded frame.
+ *      time     Time the frame was taken (msec since epoch).
+ *      sequence Position of the frame in the queue.
+ * out: none
+ */
+{
+    QMutexLocker locker(&this->timelapse_mutex);
+
+    if(sequence != this->timelapse_sequence)
+    {
+        PendingFrame pending;
+        pending.image = image;
+        pending.time = time;
+        this->pending_frames.insert(sequence, pending);
+        return;
+    }
+
+    WriteTimelapse(image, time);
+    this->timelapse_sequence++;
+
+    // At most one frame per worker can be waiting.
+    while(!this->pending_frames.isEmpty() && this->pending_frames.firstKey() == this->timelapse_sequence)
+    {
+        PendingFrame pending = this->pending_frames.take(this->timelapse_sequence);
+        WriteTimelapse(pending.image, pending.time);
+        this->timelapse_sequence++;
+    }
+}
+
+void ImagePipeline::WriteTimelapse(const QByteArray &image, int64_t time)
+/*
+ * Append a frame to the timelapse of the day it was taken.
+ *
+ * in:  image JPEG encoded frame.
+ *      time  Time the frame was taken (msec since epoch).
+ * out: none
+ */
+{
+    QDate day = QDateTime::fromMSecsSinceEpoch(time).date();
+    QString filename = QString("timelapse-%1.mjpeg").arg(day.toString("yyyyMMdd"));
+    QFile file(QDir(this->directory).filePath(filename));
+
+    // A new day starts a new timelapse, which is the moment to expire the old ones.
+    if(day != this->timelapse_day)
+    {
+        this->timelapse_day = day;
+        ExpireTimelapses(day);
+    }
+
+    if(file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        file.write(image);
+        file.close();
+    }
+}
+
+void ImagePipeline::ExpireTimelapses(const QDate &today)
+/*
+ * Remove the timelapses older than TIMELAPSE_DAYS days.
+ *
+ * in:  today Day of the timelapse that is being written.
+ * out: none
+ */
+{
+    QDir directory(this->directory);
+    QDate cutoff = today.addDays(-TIMELAPSE_DAYS);
+
+    foreach(const QString &filename, directory.entryList(QStringList() << "timelapse-*.mjpeg", QDir::Files))
+    {
+        QDate day = QDate::fromString(filename.mid(10, 8), "yyyyMMdd");
+
+        if(day.isValid() && day < cutoff)
+            directory.remove(filename);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef IMAGEPIPELINE_H
+#define IMAGEPIPELINE_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class post-processes the captured frames on a pool of
+ *              idle priority worker threads. Each frame is decoded once to
+ *              produce the thumbnail and preview renditions and is appended
+ *              to the timelapse of the day.
+ */
+
+#include <QThreadPool>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMap>
+#include <QString>
+#include <QDate>
+#include <stdint.h>
+
+#define THUMBNAIL_WIDTH     (80)
+#define THUMBNAIL_HEIGHT    (60)
+#define PREVIEW_WIDTH       (160)
+#define PREVIEW_HEIGHT      (120)
+#define RENDITION_QUALITY   (85)
+#define TIMELAPSE_DAYS      (14)    // days the timelapses are kept
+
+class ImagePipeline
+{
+public:
+    ImagePipeline(const QString &directory);
+    ~ImagePipeline();
+
+    void AddFrame(const QByteArray &image, int64_t time);
+    void ProcessFrame(const QByteArray &image, int64_t time, quint64 sequence);
+    void WaitForDone();
+
+    long Frames() const;
+    qint64 AverageProcessingTime() const;
+    double Utilization() const;
+
+private:
+    bool SaveRendition(const QString &filename, const QByteArray &encoded);
+    void AppendTimelapse(const QByteArray &image, int64_t time, quint64 sequence);
+    void WriteTimelapse(const QByteArray &image, int64_t time);
+    void ExpireTimelapses(const QDate &today);
+
+    QThreadPool pool;
+    QString directory;
+
+    quint64 queued_frames;
+
+    // Frames finished ahead of an earlier frame wait here, so the timelapse
+    // is written in the order the frames were queued.
+    struct PendingFrame
+    {
+        QByteArray image;
+        int64_t time;
+    };
+
+    QMutex timelapse_mutex;
+    quint64 timelapse_sequence;
+    QMap<quint64, PendingFrame> pending_frames;
+    QDate timelapse_day;
+
+    // Sequence after the frame of the renditions that were written last.
+    QMutex rendition_mutex;
+    quint64 rendition_sequence;
+
+    mutable QMutex statistics_mutex;
+    QElapsedTimer uptime;
+    long frames;
+    qint64 processing_time;
+};
+
+#endif // IMAGEPIPELINE_H
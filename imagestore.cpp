@@ -0,0 +1,176 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class decides which camera frames are worth storing.
+ *              Frames that are byte-identical or perceptually unchanged
+ *              compared to the last stored frame are skipped, distinct
+ *              frames are stored by content hash.
+ *              The perceptual check compares a small greyscale signature of
+ *              the frames. The signature is decoded directly at its reduced
+ *              size, which the JPEG decoder does without a full decode.
+ */
+
+#include "imagestore.h"
+#include <QCryptographicHash>
+#include <QImageReader>
+#include <QBuffer>
+#include <QImage>
+#include <stdlib.h>
+#include <string.h>
+
+ImageStore::ImageStore(WeatherDatabase *weatherdatabase, double threshold)
+/*
+ * Constructor.
+ *
+ * in:  weatherdatabase Database to store the frames in, NULL to only
+ *                      classify the frames.
+ *      threshold       Mean absolute difference of the signatures above
+ *                      which a frame is considered changed.
+ * out: none
+ */
+{
+    this->weatherdatabase = weatherdatabase;
+    this->threshold = threshold;
+
+    this->frames = 0;
+    this->stored_frames = 0;
+    this->bytes_saved = 0;
+    this->processing_time = 0;
+}
+
+ImageStore::Result ImageStore::AddImage(const QByteArray &image, const QDateTime &datetime)
+/*
+ * Store a frame unless it is identical or perceptually equal to the last
+ * stored frame.
+ *
+ * in:  image    JPEG encoded frame.
+ *      datetime Date and time the frame was taken.
+ * out: return   What happened to the frame.
+ */
+{
+    QElapsedTimer timer;
+    QByteArray hash, signature;
+    Result result = IMAGE_STORED;
+
+    if(image.isEmpty())
+    {
+        this->frames++;
+        return IMAGE_INVALID;
+    }
+
+    timer.start();
+
+    hash = QCryptographicHash::hash(image, QCryptographicHash::Sha1).toHex();
+
+    if(hash == this->last_hash)
+        result = IMAGE_IDENTICAL;
+    else if(!ComputeSignature(image, &signature))
+        result = IMAGE_INVALID;
+    else if(!this->last_signature.isEmpty() &&
+            Difference(signature, this->last_signature) < this->threshold)
+        result = IMAGE_UNCHANGED;
+
+    this->processing_time += timer.nsecsElapsed();
+    this->frames++;
+
+    if(result == IMAGE_STORED && this->weatherdatabase != NULL &&
+       !this->weatherdatabase->AddImageData(image, hash, datetime))
+        result = IMAGE_FAILED;
+
+    if(result == IMAGE_STORED)
+    {
+        // Compare against the last stored frame, so slow changes
+        // (e.g. dawn) still add up to a stored frame. A frame that could
+        // not be written is not a stored frame, the next one is tried again.
+        this->last_hash = hash;
+        this->last_signature = signature;
+        this->stored_frames++;
+    }
+    else if(result == IMAGE_IDENTICAL || result == IMAGE_UNCHANGED)
+    {
+        this->bytes_saved += image.size();
+    }
+
+    return result;
+}
+
+long ImageStore::Frames() const
+/*
+ * Number of frames offered to the store.
+ */
+{
+    return this->frames;
+}
+
+long ImageStore::StoredFrames() const
+/*
+ * Number of frames that have been stored.
+ */
+{
+    return this->stored_frames;
+}
+
+qint64 ImageStore::BytesSaved() const
+/*
+ * Number of image bytes that did not need to be stored.
+ */
+{
+    return this->bytes_saved;
+}
+
+qint64 ImageStore::ProcessingTime() const
+/*
+ * Total time spent on hashing and comparing frames (nsec).
+ */
+{
+    return this->processing_time;
+}
+
+bool ImageStore::ComputeSignature(const QByteArray &image, QByteArray *signature)
+/*
+ * Decode the frame at signature size into a greyscale image.
+ *
+ * in:  image     JPEG encoded frame.
+ * out: signature IMAGE_SIGNATURE_WIDTH x IMAGE_SIGNATURE_HEIGHT grey levels.
+ *      return    False if the frame could not be decoded.
+ */
+{
+    QBuffer buffer;
+    QImageReader reader;
+    QImage scaled;
+
+    buffer.setData(image);
+    buffer.open(QIODevice::ReadOnly);
+
+    reader.setDevice(&buffer);
+    reader.setScaledSize(QSize(IMAGE_SIGNATURE_WIDTH, IMAGE_SIGNATURE_HEIGHT));
+
+    if(!reader.read(&scaled))
+        return false;
+
+    scaled = scaled.convertToFormat(QImage::Format_Grayscale8);
+
+    signature->resize(IMAGE_SIGNATURE_WIDTH * IMAGE_SIGNATURE_HEIGHT);
+    for(int y = 0; y < IMAGE_SIGNATURE_HEIGHT; y++)
+        memcpy(signature->data() + y * IMAGE_SIGNATURE_WIDTH, scaled.constScanLine(y), IMAGE_SIGNATURE_WIDTH);
+
+    return true;
+}
+
+double ImageStore::Difference(const QByteArray &signature1, const QByteArray &signature2)
+/*
+ * Mean absolute difference between two signatures.
+ *
+ * in:  signature1 First signature.
+ *      signature2 Second signature.
+ * out: return     Mean absolute difference (grey levels).
+ */
+{
+    const unsigned char *p1 = (const unsigned char *)signature1.constData();
+    const unsigned char *p2 = (const unsigned char *)signature2.constData();
+    long sum = 0;
+
+    for(int i = 0; i < signature1.size(); i++)
+        sum += abs(p1[i] - p2[i]);
+
+    return (double)sum / signature1.size();
+}
@@ -0,0 +1,58 @@
+#ifndef IMAGESTORE_H
+#define IMAGESTORE_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class decides which camera frames are worth storing.
+ *              Frames that are byte-identical or perceptually unchanged
+ *              compared to the last stored frame are skipped, distinct
+ *              frames are stored by content hash.
+ */
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <weatherdatabase.h>
+
+#define IMAGE_SIGNATURE_WIDTH   (32)
+#define IMAGE_SIGNATURE_HEIGHT  (24)
+#define IMAGE_CHANGE_THRESHOLD  (3.0)   // mean absolute difference (grey levels)
+
+class ImageStore
+{
+public:
+    enum Result
+    {
+        IMAGE_STORED,
+        IMAGE_IDENTICAL,
+        IMAGE_UNCHANGED,
+        IMAGE_INVALID,
+        IMAGE_FAILED        // could not be written to the database
+    };
+
+    ImageStore(WeatherDatabase *weatherdatabase, double threshold = IMAGE_CHANGE_THRESHOLD);
+
+    Result AddImage(const QByteArray &image, const QDateTime &datetime);
+
+    long Frames() const;
+    long StoredFrames() const;
+    qint64 BytesSaved() const;
+    qint64 ProcessingTime() const;
+
+private:
+    bool ComputeSignature(const QByteArray &image, QByteArray *signature);
+    double Difference(const QByteArray &signature1, const QByteArray &signature2);
+
+    WeatherDatabase *weatherdatabase;
+    double threshold;
+
+    QByteArray last_hash;
+    QByteArray last_signature;
+
+    long frames;
+    long stored_frames;
+    qint64 bytes_saved;
+    qint64 processing_time;
+};
+
+#endif // IMAGESTORE_H
@@ -0,0 +1,141 @@
+/*
+ * Date:        19-10-2026
+ * Description: main function of the ingest server, which collects the data
+ *              of a fleet of weatherstations. With --simulate it acts as a
+ *              fleet of simulated stations instead, to benchmark a server.
+ */
+
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHostInfo>
+#include <weatherdatabase.h>
+#include <ingestserver.h>
+#include <ingestsimulator.h>
+#include <retentionmanager.h>
+
+int main(int argc, char *argv[])
+{
+    bool debugmode = false;
+    quint16 port = INGEST_PORT;
+    int raw_retention = RETENTION_RAW_DAYS;
+    int rollup_retention = RETENTION_ROLLUP_DAYS;
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Raspberry Weatherstation ingest server");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Collects the data of a fleet of weatherstations");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    // Boolean command line option with multiple names (-d, --debugmode)
+    QCommandLineOption debugOption(QStringList() << "d" << "debugmode", "Enable debugmode");
+    parser.addOption(debugOption);
+
+    QCommandLineOption portOption(QStringList() << "port", "UDP port of the ingest server", "port");
+    parser.addOption(portOption);
+
+    // Command line options with a value (-r, --retention <days>, --rollup-retention <days>)
+    QCommandLineOption retentionOption(QStringList() << "r" << "retention",
+                                       "Days to keep raw station data (0 = forever)", "days");
+    parser.addOption(retentionOption);
+    QCommandLineOption rollupRetentionOption(QStringList() << "rollup-retention",
+                                             "Days to keep hourly station data (0 = forever)", "days");
+    parser.addOption(rollupRetentionOption);
+
+    // Load generator options
+    QCommandLineOption simulateOption(QStringList() << "simulate", "Simulate a fleet of stations", "stations");
+    parser.addOption(simulateOption);
+    QCommandLineOption hostOption(QStringList() << "host", "Ingest server to simulate against", "host", "localhost");
+    parser.addOption(hostOption);
+    QCommandLineOption recordsOption(QStringList() << "records", "Records per batch", "records", "3");
+    parser.addOption(recordsOption);
+    QCommandLineOption intervalOption(QStringList() << "interval", "Batch interval per station (msec)", "msec", "60000");
+    parser.addOption(intervalOption);
+    QCommandLineOption durationOption(QStringList() << "duration", "Duration of the simulation (sec)", "sec", "60");
+    parser.addOption(durationOption);
+
+    // Process the actual command line arguments given by the user
+    parser.process(app);
+
+    debugmode = parser.isSet(debugOption);
+    if(parser.isSet(portOption))
+    {
+        bool ok = false;
+        port = parser.value(portOption).toUShort(&ok);
+
+        if(!ok || port == 0)
+        {
+            qCritical() << "Invalid port" << parser.value(portOption);
+            return 1;
+        }
+    }
+
+    if(parser.isSet(retentionOption))
+    {
+        bool ok = false;
+        raw_retention = parser.value(retentionOption).toInt(&ok);
+
+        if(!ok || raw_retention < 0)
+        {
+            qCritical() << "Invalid retention" << parser.value(retentionOption) << ", use a number of days";
+            return 1;
+        }
+    }
+
+    if(parser.isSet(rollupRetentionOption))
+    {
+        bool ok = false;
+        rollup_retention = parser.value(rollupRetentionOption).toInt(&ok);
+
+        if(!ok || rollup_retention < 0)
+        {
+            qCritical() << "Invalid rollup retention" << parser.value(rollupRetentionOption) << ", use a number of days";
+            return 1;
+        }
+    }
+
+    if(parser.isSet(simulateOption))
+    {
+        QHostInfo info = QHostInfo::fromName(parser.value(hostOption));
+
+        if(info.addresses().isEmpty())
+        {
+            qCritical() << "Unable to resolve" << parser.value(hostOption);
+            return 1;
+        }
+
+        IngestSimulator *simulator = new IngestSimulator(info.addresses().first(), port,
+                                                         parser.value(simulateOption).toInt(),
+                                                         parser.value(recordsOption).toInt(),
+                                                         parser.value(intervalOption).toInt(),
+                                                         parser.value(durationOption).toInt());
+        if(!simulator->Start())
+            return 1;
+
+        return app.exec();
+    }
+
+    WeatherDatabase *weatherdatabase = new WeatherDatabase();
+
+    if(!weatherdatabase->OpenDatabase())
+    {
+        qCritical() << "Unable to open the database for the ingest server";
+        return 1;
+    }
+
+    // The stations leave the expiry of their data to the ingest server in
+    // client mode, stationdata is partitioned and rolled up like the data
+    // of a single station.
+    RetentionManager *retentionmanager = new RetentionManager(QSqlDatabase::database(), raw_retention,
+                                                              rollup_retention, debugmode);
+    retentionmanager->start(QThread::LowPriority);
+
+    IngestServer *ingestserver = new IngestServer(weatherdatabase, port, debugmode);
+    if(!ingestserver->Start())
+        return 1;
+
+    return app.exec();
+}
@@ -0,0 +1,147 @@
+#ifndef INGESTPROTOCOL_H
+#define INGESTPROTOCOL_H
+
+/*
+ * Date:        19-10-2026
+ * Description: Binary protocol between the weatherstations and the ingest
+ *              server. Stations send batches of samples in UDP datagrams,
+ *              the server acknowledges each batch by its sequence number
+ *              once it has been stored. Unacknowledged batches are resent,
+ *              the server ignores batches it already stored.
+ *
+ *              All fields are little endian and have a fixed layout:
+ *
+ *              header (20 bytes)
+ *                  0   uint32  magic           INGEST_MAGIC
+ *                  4   uint16  version         INGEST_VERSION
+ *                  6   uint16  type            INGEST_TYPE_*
+ *                  8   uint32  station         station id
+ *                  12  uint32  sequence        batch sequence number
+ *                  16  uint16  count           number of records
+ *                  18  uint16  reserved
+ *              record (16 bytes, count times, batches only)
+ *                  0   int64   time            msec since epoch
+ *                  8   float   value
+ *                  12  uint8   quantity        WeatherQuantity
+ *                  13  uint8   reserved[3]
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define INGEST_PORT             (47800)
+#define INGEST_MAGIC            (0x31495357)    // "WSI1"
+#define INGEST_VERSION          (1)
+
+#define INGEST_TYPE_BATCH       (1)
+#define INGEST_TYPE_ACK         (2)
+
+#define INGEST_HEADER_SIZE      (20)
+#define INGEST_RECORD_SIZE      (16)
+#define INGEST_MAX_RECORDS      (64)            // keeps a batch within a single ethernet frame
+#define INGEST_MAX_DATAGRAM     (INGEST_HEADER_SIZE + INGEST_MAX_RECORDS * INGEST_RECORD_SIZE)
+
+struct IngestHeader
+{
+    uint16_t version;
+    uint16_t type;
+    uint32_t station;
+    uint32_t sequence;
+    uint16_t count;
+};
+
+struct IngestRecord
+{
+    int64_t time;
+    float value;
+    uint8_t quantity;
+};
+
+static inline void ingest_put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v; p[1] = v >> 8;
+}
+
+static inline void ingest_put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static inline uint16_t ingest_get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t ingest_get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void ingest_encode_header(uint8_t *p, const IngestHeader &header)
+/*
+ * Encode a header into the first INGEST_HEADER_SIZE bytes of a datagram.
+ */
+{
+    ingest_put32(p, INGEST_MAGIC);
+    ingest_put16(p + 4, header.version);
+    ingest_put16(p + 6, header.type);
+    ingest_put32(p + 8, header.station);
+    ingest_put32(p + 12, header.sequence);
+    ingest_put16(p + 16, header.count);
+    ingest_put16(p + 18, 0);
+}
+
+static inline bool ingest_decode_header(const uint8_t *p, int size, IngestHeader *header)
+/*
+ * Decode and validate the header of a datagram.
+ *
+ * in:  p      Datagram.
+ *      size   Size of the datagram.
+ * out: header Decoded header.
+ *      return False if the datagram is not a valid datagram of this version.
+ */
+{
+    if(size < INGEST_HEADER_SIZE || ingest_get32(p) != INGEST_MAGIC)
+        return false;
+
+    header->version = ingest_get16(p + 4);
+    header->type = ingest_get16(p + 6);
+    header->station = ingest_get32(p + 8);
+    header->sequence = ingest_get32(p + 12);
+    header->count = ingest_get16(p + 16);
+
+    if(header->version != INGEST_VERSION || header->count > INGEST_MAX_RECORDS)
+        return false;
+
+    return size == INGEST_HEADER_SIZE + header->count * INGEST_RECORD_SIZE;
+}
+
+static inline void ingest_encode_record(uint8_t *p, const IngestRecord &record)
+/*
+ * Encode a record into INGEST_RECORD_SIZE bytes.
+ */
+{
+    uint32_t value;
+
+    memcpy(&value, &record.value, sizeof(value));
+
+    ingest_put32(p, (uint64_t)record.time);
+    ingest_put32(p + 4, (uint64_t)record.time >> 32);
+    ingest_put32(p + 8, value);
+    p[12] = record.quantity;
+    p[13] = p[14] = p[15] = 0;
+}
+
+static inline void ingest_decode_record(const uint8_t *p, IngestRecord *record)
+/*
+ * Decode a record of INGEST_RECORD_SIZE bytes.
+ */
+{
+    uint32_t value = ingest_get32(p + 8);
+
+    record->time = (int64_t)(ingest_get32(p) | ((uint64_t)ingest_get32(p + 4) << 32));
+    memcpy(&record->value, &value, sizeof(value));
+    record->quantity = p[12];
+}
+
+#endif // INGESTPROTOCOL_H
@@ -0,0 +1,270 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class receives the sample batches of a fleet of
+ *              weatherstations (see ingestprotocol.h) and stores them in the
+ *              weatherdatabase in large transactions. Batches are acknowledged
+ *              once they have been stored.
+ *              All stations share a single UDP socket, so the event loop
+ *              watches one file descriptor no matter how large the fleet is.
+ *              The datagrams are drained in a loop on every wake up.
+ */
+
+#include "ingestserver.h"
+#include <QDebug>
+
+IngestServer::IngestServer(WeatherDatabase *weatherdatabase, quint16 port, bool debugmode)
+/*
+ * Constructor.
+ *
+ * in:  weatherdatabase Opened database to store the samples in.
+ *      port            UDP port to receive the batches on.
+ *      debugmode       Report statistics even when idle.
+ * out: none
+ */
+{
+    this->weatherdatabase = weatherdatabase;
+    this->port = port;
+    this->debugmode = debugmode;
+    this->retry_interval = 0;
+
+    this->datagrams = 0;
+    this->duplicates = 0;
+    this->rows_written = 0;
+    this->flush_time = 0;
+    this->flushes = 0;
+}
+
+bool IngestServer::Start()
+/*
+ * Start receiving batches.
+ *
+ * in:  none
+ * out: return False if the port could not be bound.
+ */
+{
+    if(!this->socket.bind(QHostAddress::Any, this->port))
+    {
+        qWarning() << "Ingest server: unable to bind port" << this->port << ":" << this->socket.errorString();
+        return false;
+    }
+
+    // Bursts are buffered by the kernel while a transaction is written.
+    this->socket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, INGEST_RECEIVE_BUFFER);
+
+    connect(&this->socket, SIGNAL(readyRead()), this, SLOT(ReadDatagrams()));
+    connect(&this->flush_timer, SIGNAL(timeout()), this, SLOT(FlushSamples()));
+    connect(&this->retry_timer, SIGNAL(timeout()), this, SLOT(FlushSamples()));
+    connect(&this->report_timer, SIGNAL(timeout()), this, SLOT(Report()));
+
+    this->samples.reserve(INGEST_FLUSH_ROWS + INGEST_MAX_RECORDS);
+    this->retry_timer.setSingleShot(true);
+    this->flush_timer.start(INGEST_FLUSH_INTERVAL);
+    this->report_timer.start(INGEST_REPORT_INTERVAL);
+    this->report_clock.start();
+
+    return true;
+}
+
+void IngestServer::ReadDatagrams()
+/*
+ * Decode all pending batches. New samples are buffered until the next flush,
+ * duplicate batches are only acknowledged again.
+ */
+{
+    uint8_t buffer[INGEST_MAX_DATAGRAM];
+    IngestHeader header;
+    IngestRecord record;
+    PendingAck ack;
+
+    while(this->socket.hasPendingDatagrams())
+    {
+        int size = this->socket.readDatagram((char *)buffer, sizeof(buffer), &ack.address, &ack.port);
+
+        this->datagrams++;
+
+        if(!ingest_decode_header(buffer, size, &header) || header.type != INGEST_TYPE_BATCH)
+            continue;
+
+        if(!IsDuplicate(header.station, header.sequence))
+        {
+            for(int i = 0; i < header.count; i++)
+            {
+                StationSample sample;
+
+                ingest_decode_record(buffer + INGEST_HEADER_SIZE + i * INGEST_RECORD_SIZE, &record);
+
+                if(record.quantity >= QUANTITY_COUNT)
+                    continue;
+
+                sample.station = header.station;
+                sample.time = record.time;
+                sample.quantity = record.quantity;
+                sample.value = record.value;
+                this->samples.append(sample);
+            }
+        }
+        else
+        {
+            this->duplicates++;
+        }
+
+        ack.station = header.station;
+        ack.sequence = header.sequence;
+        this->pending_acks.append(ack);
+    }
+
+    if(this->samples.size() >= INGEST_FLUSH_ROWS)
+        FlushSamples();
+}
+
+void IngestServer::FlushSamples()
+/*
+ * Store the buffered samples in a single transaction and acknowledge the
+ * batches they came from. When the database is unavailable the samples are
+ * kept, and the next attempt is made by the retry timer with an exponential
+ * backoff instead of on every datagram, on a reopened connection.
+ */
+{
+    QElapsedTimer timer;
+
+    if(this->samples.isEmpty() && this->pending_acks.isEmpty())
+        return;
+
+    if(this->retry_timer.isActive())
+        return;
+
+    timer.start();
+
+    // The driver does not reconnect once the server went away, a retry
+    // starts on a new connection.
+    if(this->retry_interval > 0)
+    {
+        this->weatherdatabase->CloseDatabase();
+        if(!this->weatherdatabase->OpenDatabase())
+            qWarning() << "Ingest server: unable to reconnect to the database";
+    }
+
+    if(!this->samples.isEmpty() && !this->weatherdatabase->AddStationData(this->samples))
+    {
+        this->retry_interval = qBound(INGEST_RETRY_MIN, this->retry_interval * 2, INGEST_RETRY_MAX);
+        this->retry_timer.start(this->retry_interval);
+
+        qWarning() << "Ingest server: unable to store" << this->samples.size() << "samples, retrying in"
+                   << this->retry_interval << "msec";
+
+        if(this->samples.size() > INGEST_MAX_BUFFERED)
+        {
+            // Forget the received sequence numbers, so the stations can resend.
+            qWarning() << "Ingest server: database unavailable, dropping" << this->samples.size() << "samples";
+            this->samples.clear();
+            this->pending_acks.clear();
+            this->stations.clear();
+        }
+        return;
+    }
+
+    this->retry_interval = 0;
+    this->rows_written += this->samples.size();
+    this->flush_time += timer.nsecsElapsed();
+    this->flushes++;
+    this->samples.clear();
+
+    foreach(const PendingAck &ack, this->pending_acks)
+        SendAck(ack.address, ack.port, ack.station, ack.sequence);
+    this->pending_acks.clear();
+}
+
+void IngestServer::Report()
+/*
+ * Report the throughput since the previous report.
+ */
+{
+    double seconds = this->report_clock.restart() / 1000.0;
+
+    if(this->datagrams > 0 || this->debugmode)
+        qDebug() << "Ingest server:" << this->stations.size() << "stations,"
+                 << this->datagrams / seconds << "datagrams/s,"
+                 << this->rows_written / seconds << "rows/s,"
+                 << this->duplicates << "duplicates,"
+                 << (this->flushes > 0 ? this->flush_time / this->flushes / 1000000.0 : 0.0) << "msec per flush";
+
+    this->datagrams = 0;
+    this->duplicates = 0;
+    this->rows_written = 0;
+    this->flush_time = 0;
+    this->flushes = 0;
+}
+
+bool IngestServer::IsDuplicate(quint32 station, quint32 sequence)
+/*
+ * Check whether a batch has been received before and mark it as received.
+ * Per station the last INGEST_SEQUENCE_WINDOW sequence numbers are tracked,
+ * which covers all batches a station can resend. A sequence number before
+ * the window means the station restarted.
+ *
+ * in:  station  Id of the station.
+ *      sequence Sequence number of the batch.
+ * out: return   True if the batch has been received before.
+ */
+{
+    QHash<quint32, StationState>::iterator it = this->stations.find(station);
+
+    if(it == this->stations.end())
+    {
+        StationState state;
+        state.highest_sequence = sequence;
+        state.received = QBitArray(INGEST_SEQUENCE_WINDOW);
+        state.received.setBit(sequence % INGEST_SEQUENCE_WINDOW);
+        this->stations.insert(station, state);
+        return false;
+    }
+
+    qint32 distance = (qint32)(sequence - it->highest_sequence);
+
+    if(distance > 0)
+    {
+        // Slide the window forward, clearing the sequence numbers it passes.
+        if(distance >= INGEST_SEQUENCE_WINDOW)
+            it->received.fill(false);
+        else
+            for(quint32 s = it->highest_sequence + 1; s != sequence; s++)
+                it->received.clearBit(s % INGEST_SEQUENCE_WINDOW);
+
+        it->highest_sequence = sequence;
+        it->received.setBit(sequence % INGEST_SEQUENCE_WINDOW);
+        return false;
+    }
+
+    if(distance <= -INGEST_SEQUENCE_WINDOW)
+    {
+        it->highest_sequence = sequence;
+        it->received.fill(false);
+        it->received.setBit(sequence % INGEST_SEQUENCE_WINDOW);
+        return false;
+    }
+
+    if(it->received.testBit(sequence % INGEST_SEQUENCE_WINDOW))
+        return true;
+
+    it->received.setBit(sequence % INGEST_SEQUENCE_WINDOW);
+    return false;
+}
+
+void IngestServer::SendAck(const QHostAddress &address, quint16 port, quint32 station, quint32 sequence)
+/*
+ * Acknowledge a batch to its station.
+ */
+{
+    uint8_t datagram[INGEST_HEADER_SIZE];
+    IngestHeader header;
+
+    header.version = INGEST_VERSION;
+    header.type = INGEST_TYPE_ACK;
+    header.station = station;
+    header.sequence = sequence;
+    header.count = 0;
+
+    ingest_encode_header(datagram, header);
+
+    this->socket.writeDatagram((const char *)datagram, sizeof(datagram), address, port);
+}
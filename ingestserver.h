@@ -0,0 +1,84 @@
+#ifndef INGESTSERVER_H
+#define INGESTSERVER_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class receives the sample batches of a fleet of
+ *              weatherstations (see ingestprotocol.h) and stores them in the
+ *              weatherdatabase in large transactions. Batches are acknowledged
+ *              once they have been stored.
+ */
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+#include <QBitArray>
+#include <QElapsedTimer>
+#include <weatherdatabase.h>
+
+#define INGEST_FLUSH_ROWS       (20000)         // rows per transaction
+#define INGEST_FLUSH_INTERVAL   (1000)          // msec
+#define INGEST_MAX_BUFFERED     (2000000)       // rows kept while the database is unavailable
+#define INGEST_RETRY_MIN        (1000)          // msec before the first retry of a failed flush
+#define INGEST_RETRY_MAX        (60000)         // msec between retries while the database stays down
+#define INGEST_SEQUENCE_WINDOW  (INGEST_MAX_UNACKED)
+#define INGEST_RECEIVE_BUFFER   (8 * 1024 * 1024)
+#define INGEST_REPORT_INTERVAL  (10000)         // msec
+
+class IngestServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    IngestServer(WeatherDatabase *weatherdatabase, quint16 port, bool debugmode);
+
+    bool Start();
+
+private slots:
+    void ReadDatagrams();
+    void FlushSamples();
+    void Report();
+
+private:
+    struct StationState
+    {
+        quint32 highest_sequence;
+        QBitArray received;
+    };
+
+    struct PendingAck
+    {
+        QHostAddress address;
+        quint16 port;
+        quint32 station;
+        quint32 sequence;
+    };
+
+    bool IsDuplicate(quint32 station, quint32 sequence);
+    void SendAck(const QHostAddress &address, quint16 port, quint32 station, quint32 sequence);
+
+    WeatherDatabase *weatherdatabase;
+    QUdpSocket socket;
+    QTimer flush_timer;
+    QTimer retry_timer;
+    QTimer report_timer;
+    int retry_interval;
+    quint16 port;
+    bool debugmode;
+
+    QHash<quint32, StationState> stations;
+    QVector<StationSample> samples;
+    QVector<PendingAck> pending_acks;
+
+    // Statistics since the last report
+    QElapsedTimer report_clock;
+    qint64 datagrams;
+    qint64 duplicates;
+    qint64 rows_written;
+    qint64 flush_time;
+    int flushes;
+};
+
+#endif // INGESTSERVER_H
@@ -0,0 +1,173 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class simulates a fleet of weatherstations sending
+ *              batches to an ingest server, to measure the throughput and
+ *              acknowledgement latency of the server.
+ *              The batches of the stations are spread evenly over the send
+ *              interval. Every second the send and acknowledgement rate and
+ *              the latency percentiles are reported.
+ */
+
+#include "ingestsimulator.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <math.h>
+
+IngestSimulator::IngestSimulator(const QHostAddress &address, quint16 port, int stations,
+                                 int records, int interval, int duration)
+/*
+ * Constructor.
+ *
+ * in:  address  Address of the ingest server.
+ *      port     UDP port of the ingest server.
+ *      stations Number of simulated stations.
+ *      records  Number of records per batch.
+ *      interval Time between two batches of a station (msec).
+ *      duration Duration of the simulation (sec).
+ * out: none
+ */
+{
+    this->address = address;
+    this->port = port;
+    this->stations = stations;
+    this->records = qBound(1, records, INGEST_MAX_RECORDS);
+    this->interval = qMax(1, interval);
+    this->duration = duration;
+
+    // Like a station, start at a different sequence number on every run, so
+    // the batches of a second run are not taken for duplicates of the first.
+    this->sequences.fill((quint32)QDateTime::currentMSecsSinceEpoch(), stations);
+    this->batches_sent = 0;
+    this->batches_acked = 0;
+    this->report_sent = 0;
+    this->report_acked = 0;
+}
+
+bool IngestSimulator::Start()
+/*
+ * Start the simulation.
+ *
+ * in:  none
+ * out: return False if no socket could be opened.
+ */
+{
+    if(!this->socket.bind())
+        return false;
+
+    connect(&this->socket, SIGNAL(readyRead()), this, SLOT(ReadAcks()));
+    connect(&this->tick_timer, SIGNAL(timeout()), this, SLOT(Tick()));
+    connect(&this->report_timer, SIGNAL(timeout()), this, SLOT(Report()));
+
+    this->clock.start();
+    this->tick_timer.start(SIMULATOR_TICK_INTERVAL);
+    this->report_timer.start(1000);
+
+    return true;
+}
+
+void IngestSimulator::Tick()
+/*
+ * Send the batches that are due. The stations take turns, so the load is
+ * spread evenly over the interval.
+ */
+{
+    qint64 elapsed = this->clock.elapsed();
+    qint64 due = elapsed * this->stations / this->interval;
+
+    if(elapsed >= this->duration * 1000LL)
+    {
+        this->tick_timer.stop();
+        // Give the last acknowledgements some time to arrive.
+        QTimer::singleShot(SIMULATOR_DRAIN_TIME, QCoreApplication::instance(), SLOT(quit()));
+        return;
+    }
+
+    while(this->batches_sent < due)
+        SendBatch(this->batches_sent % this->stations);
+}
+
+void IngestSimulator::ReadAcks()
+/*
+ * Match the acknowledgements with the batches sent.
+ */
+{
+    uint8_t buffer[INGEST_MAX_DATAGRAM];
+    IngestHeader header;
+
+    while(this->socket.hasPendingDatagrams())
+    {
+        int size = this->socket.readDatagram((char *)buffer, sizeof(buffer));
+
+        if(!ingest_decode_header(buffer, size, &header) || header.type != INGEST_TYPE_ACK)
+            continue;
+
+        quint64 key = ((quint64)header.station << 32) | header.sequence;
+        QHash<quint64, qint64>::iterator it = this->send_times.find(key);
+
+        if(it != this->send_times.end())
+        {
+            this->latencies.append(this->clock.nsecsElapsed() - it.value());
+            this->send_times.erase(it);
+            this->batches_acked++;
+        }
+    }
+}
+
+void IngestSimulator::Report()
+/*
+ * Report the rates and latencies of the last second.
+ */
+{
+    double p50 = 0, p99 = 0;
+
+    if(!this->latencies.isEmpty())
+    {
+        std::sort(this->latencies.begin(), this->latencies.end());
+        p50 = this->latencies[this->latencies.size() / 2] / 1000000.0;
+        p99 = this->latencies[(int)floor(this->latencies.size() * 0.99)] / 1000000.0;
+    }
+
+    qDebug() << "Simulator:" << (this->batches_sent - this->report_sent) << "batches/s sent,"
+             << (this->batches_sent - this->report_sent) * this->records << "records/s,"
+             << (this->batches_acked - this->report_acked) << "acks/s,"
+             << "latency p50" << p50 << "msec, p99" << p99 << "msec,"
+             << this->send_times.size() << "unacknowledged";
+
+    this->report_sent = this->batches_sent;
+    this->report_acked = this->batches_acked;
+    this->latencies.clear();
+}
+
+void IngestSimulator::SendBatch(quint32 station)
+/*
+ * Send a batch of random samples for a station.
+ */
+{
+    uint8_t datagram[INGEST_MAX_DATAGRAM];
+    IngestHeader header;
+    IngestRecord record;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    header.version = INGEST_VERSION;
+    header.type = INGEST_TYPE_BATCH;
+    header.station = station;
+    header.sequence = this->sequences[station]++;
+    header.count = this->records;
+
+    ingest_encode_header(datagram, header);
+
+    for(int i = 0; i < this->records; i++)
+    {
+        record.time = now - (this->records - i) * 1000;
+        record.quantity = i % 3;
+        record.value = 10.0f + (float)(qrand() % 1000) / 100.0f;
+        ingest_encode_record(datagram + INGEST_HEADER_SIZE + i * INGEST_RECORD_SIZE, record);
+    }
+
+    this->send_times.insert(((quint64)station << 32) | header.sequence, this->clock.nsecsElapsed());
+    this->socket.writeDatagram((const char *)datagram, INGEST_HEADER_SIZE + this->records * INGEST_RECORD_SIZE,
+                               this->address, this->port);
+    this->batches_sent++;
+}
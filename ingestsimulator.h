@@ -0,0 +1,60 @@
+#ifndef INGESTSIMULATOR_H
+#define INGESTSIMULATOR_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class simulates a fleet of weatherstations sending
+ *              batches to an ingest server, to measure the throughput and
+ *              acknowledgement latency of the server.
+ */
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include <ingestprotocol.h>
+
+#define SIMULATOR_TICK_INTERVAL (5)     // msec
+#define SIMULATOR_DRAIN_TIME    (2000)  // msec to wait for the last acknowledgements
+
+class IngestSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    IngestSimulator(const QHostAddress &address, quint16 port, int stations,
+                    int records, int interval, int duration);
+
+    bool Start();
+
+private slots:
+    void Tick();
+    void ReadAcks();
+    void Report();
+
+private:
+    void SendBatch(quint32 station);
+
+    QUdpSocket socket;
+    QTimer tick_timer;
+    QTimer report_timer;
+    QHostAddress address;
+    quint16 port;
+    int stations;
+    int records;
+    int interval;
+    int duration;
+
+    QElapsedTimer clock;
+    QVector<quint32> sequences;
+    QHash<quint64, qint64> send_times;
+    QVector<qint64> latencies;
+    qint64 batches_sent;
+    qint64 batches_acked;
+    qint64 report_sent;
+    qint64 report_acked;
+};
+
+#endif // INGESTSIMULATOR_H
@@ -8,10 +8,15 @@
 #include <QCoreApplication>
 #include <QCommandLineParser>
 #include <weatherstation.h>
+#include <bulkimporter.h>
+#include <columnexporter.h>
+#include <limits.h>
 
 int main(int argc, char *argv[])
 {
     bool purge_database, debugmode = false;
+    int raw_retention = RETENTION_RAW_DAYS;
+    int rollup_retention = RETENTION_ROLLUP_DAYS;
 
     QCoreApplication app(argc, argv);
     QCoreApplication::setApplicationName("Raspberry Weatherstation");
@@ -30,13 +35,233 @@ int main(int argc, char *argv[])
     QCommandLineOption purgeOption(QStringList() << "p" << "purge", "Purge weather database");
     parser.addOption(purgeOption);
 
+    // Command line options with a value (-r, --retention <days>, --rollup-retention <days>)
+    QCommandLineOption retentionOption(QStringList() << "r" << "retention",
+                                       "Days to keep raw weather data and camera frames (0 = forever)", "days");
+    parser.addOption(retentionOption);
+    QCommandLineOption rollupRetentionOption(QStringList() << "rollup-retention",
+                                             "Days to keep hourly weather data (0 = forever)", "days");
+    parser.addOption(rollupRetentionOption);
+
+    // Command line option with a value (-b, --deadband <temperature,humidity,airpressure>)
+    QCommandLineOption deadbandOption(QStringList() << "b" << "deadband",
+                                      "Tolerance of the stored temperature, humidity and air pressure",
+                                      "temperature,humidity,airpressure");
+    parser.addOption(deadbandOption);
+
+    // Command line options with a value (--http-port <port>, --http-address <address>)
+    QCommandLineOption httpPortOption(QStringList() << "http-port",
+                                      "Port of the HTTP interface, e.g. 8080 (default 0 = disabled)", "port");
+    parser.addOption(httpPortOption);
+    QCommandLineOption httpAddressOption(QStringList() << "http-address",
+                                         "Address the HTTP interface listens on, 0.0.0.0 for all (unauthenticated)",
+                                         "address", HTTP_ADDRESS);
+    parser.addOption(httpAddressOption);
+
+    // Command line options with a value (--ingest-server <host[:port]>, --station-id <id>)
+    QCommandLineOption ingestServerOption(QStringList() << "ingest-server",
+                                          "Send the data to an ingest server instead of the database", "host[:port]");
+    parser.addOption(ingestServerOption);
+    QCommandLineOption stationIdOption(QStringList() << "station-id",
+                                       "Id of this station at the ingest server", "id", "0");
+    parser.addOption(stationIdOption);
+
+    // Command line option with a value (--import <file>), may be given multiple times
+    QCommandLineOption importOption(QStringList() << "import",
+                                    "Import the readings of a CSV file into the database and exit", "file");
+    parser.addOption(importOption);
+
+    // Command line options with a value (--export <file>, --from <datetime>, --to <datetime>, --columns <columns>)
+    QCommandLineOption exportOption(QStringList() << "export",
+                                    "Export the readings to a columnar file and exit", "file");
+    parser.addOption(exportOption);
+    QCommandLineOption fromOption(QStringList() << "from", "Start of the export (yyyy-MM-ddTHH:mm:ss)", "datetime");
+    parser.addOption(fromOption);
+    QCommandLineOption toOption(QStringList() << "to", "End of the export, exclusive (yyyy-MM-ddTHH:mm:ss)", "datetime");
+    parser.addOption(toOption);
+    QCommandLineOption columnsOption(QStringList() << "columns", "Quantities to export",
+                                     "temperature,humidity,airpressure", "temperature,humidity,airpressure");
+    parser.addOption(columnsOption);
+
     // Process the actual command line arguments given by the user
     parser.process(app);
 
     debugmode = parser.isSet(debugOption);
     purge_database = parser.isSet(purgeOption);
 
-    WeatherStation *weatherstation = new WeatherStation(purge_database, debugmode);
+    if(parser.isSet(retentionOption))
+    {
+        bool ok = false;
+        raw_retention = parser.value(retentionOption).toInt(&ok);
+
+        if(!ok || raw_retention < 0)
+        {
+            qCritical() << "Invalid retention" << parser.value(retentionOption) << ", use a number of days";
+            return 1;
+        }
+    }
+
+    if(parser.isSet(rollupRetentionOption))
+    {
+        bool ok = false;
+        rollup_retention = parser.value(rollupRetentionOption).toInt(&ok);
+
+        if(!ok || rollup_retention < 0)
+        {
+            qCritical() << "Invalid rollup retention" << parser.value(rollupRetentionOption) << ", use a number of days";
+            return 1;
+        }
+    }
+
+    if(parser.isSet(importOption))
+    {
+        WeatherDatabase *weatherdatabase = new WeatherDatabase();
+
+        if(!weatherdatabase->OpenDatabase())
+        {
+            qCritical() << "Unable to open the database for the import";
+            return 1;
+        }
+
+        if(purge_database)
+            weatherdatabase->PurgeDatabase();
+
+        BulkImporter importer(weatherdatabase, debugmode);
+        bool success = true;
+
+        foreach(const QString &filename, parser.values(importOption))
+            success = importer.ImportFile(filename) && success;
+
+        weatherdatabase->CloseDatabase();
+
+        return success ? 0 : 1;
+    }
+
+    if(parser.isSet(exportOption))
+    {
+        QVector<WeatherQuantity> quantities;
+        qint64 from = 0;
+        qint64 to = LLONG_MAX;
+
+        foreach(const QString &column, parser.value(columnsOption).split(","))
+        {
+            WeatherQuantity quantity;
+
+            if(!ColumnExporter::ParseQuantity(column.trimmed(), &quantity))
+            {
+                qCritical() << "Unknown column" << column;
+                return 1;
+            }
+            quantities.append(quantity);
+        }
+
+        QDateTime from_datetime = QDateTime::fromString(parser.value(fromOption), Qt::ISODate);
+        QDateTime to_datetime = QDateTime::fromString(parser.value(toOption), Qt::ISODate);
+
+        if((parser.isSet(fromOption) && !from_datetime.isValid()) || (parser.isSet(toOption) && !to_datetime.isValid()))
+        {
+            qCritical() << "Invalid export range, use yyyy-MM-ddTHH:mm:ss";
+            return 1;
+        }
+
+        if(parser.isSet(fromOption))
+            from = from_datetime.toMSecsSinceEpoch();
+        if(parser.isSet(toOption))
+            to = to_datetime.toMSecsSinceEpoch();
+
+        WeatherDatabase *weatherdatabase = new WeatherDatabase();
+
+        if(!weatherdatabase->OpenDatabase())
+        {
+            qCritical() << "Unable to open the database for the export";
+            return 1;
+        }
+
+        ColumnExporter exporter(weatherdatabase, debugmode);
+        bool success = exporter.Export(parser.value(exportOption), from, to, quantities);
+
+        weatherdatabase->CloseDatabase();
+
+        return success ? 0 : 1;
+    }
+
+    float tolerances[QUANTITY_COUNT];
+    int http_port = HTTP_PORT;
+    QString ingest_host;
+    quint16 ingest_port = INGEST_PORT;
+    quint32 station_id = 0;
+
+    if(parser.isSet(httpPortOption))
+    {
+        bool ok = false;
+        http_port = parser.value(httpPortOption).toInt(&ok);
+
+        if(!ok || http_port < 0 || http_port > 65535)
+        {
+            qCritical() << "Invalid HTTP port" << parser.value(httpPortOption);
+            return 1;
+        }
+    }
+
+    if(QHostAddress(parser.value(httpAddressOption)).isNull())
+    {
+        qCritical() << "Invalid HTTP address" << parser.value(httpAddressOption);
+        return 1;
+    }
+
+    if(parser.isSet(deadbandOption))
+    {
+        QStringList values = parser.value(deadbandOption).split(",");
+        bool ok = (values.size() == QUANTITY_COUNT);
+
+        for(int i = 0; ok && i < QUANTITY_COUNT; i++)
+        {
+            tolerances[i] = values[i].trimmed().toFloat(&ok);
+            ok = ok && tolerances[i] >= 0;
+        }
+
+        if(!ok)
+        {
+            qCritical() << "Invalid deadband" << parser.value(deadbandOption) << ", use temperature,humidity,airpressure";
+            return 1;
+        }
+    }
+
+    if(parser.isSet(ingestServerOption))
+    {
+        QStringList server = parser.value(ingestServerOption).split(":");
+        bool ok = (server.size() <= 2 && !server[0].isEmpty());
+
+        ingest_host = server[0];
+        if(ok && server.size() > 1)
+            ingest_port = server[1].toUShort(&ok);
+
+        if(!ok || ingest_port == 0)
+        {
+            qCritical() << "Invalid ingest server" << parser.value(ingestServerOption) << ", use host[:port]";
+            return 1;
+        }
+
+        station_id = parser.value(stationIdOption).toUInt(&ok);
+
+        if(!ok)
+        {
+            qCritical() << "Invalid station id" << parser.value(stationIdOption);
+            return 1;
+        }
+    }
+
+    WeatherStation *weatherstation = new WeatherStation(purge_database, debugmode, raw_retention, rollup_retention);
+
+    if(parser.isSet(deadbandOption))
+        weatherstation->set_deadband(tolerances[0], tolerances[1], tolerances[2]);
+
+    weatherstation->set_http_interface(parser.value(httpAddressOption), http_port);
+
+    if(parser.isSet(ingestServerOption))
+    {
+        weatherstation->set_ingest_server(ingest_host, ingest_port, station_id);
+    }
 
     weatherstation->start_acquisition();
 
@@ -0,0 +1,470 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class expires old weather data in the background. The raw
+ *              data tables are partitioned per day and the hourly rollup tables
+ *              per month, so expired data is removed by dropping whole
+ *              partitions instead of deleting rows.
+ *              Before a raw partition is dropped its samples are summarized
+ *              into the hourly rollup table of the same quantity. The samples
+ *              of the fleet (stationdata) are summarized per station and
+ *              quantity.
+ *              The image index expires with the raw samples, after which the
+ *              frames it no longer references are deleted.
+ */
+
+#include "retentionmanager.h"
+#include <QSqlError>
+
+// Difference between the MySQL TO_DAYS() value and the julian day of a date.
+#define TO_DAYS_JULIAN_OFFSET (1721060)
+
+#define RETENTION_TABLES (4)
+
+static const char *raw_tables[RETENTION_TABLES]    = { "temperaturedata", "humiditydata", "airpressuredata",
+                                                       "stationdata" };
+static const char *rollup_tables[RETENTION_TABLES] = { "temperaturedata_hourly", "humiditydata_hourly",
+                                                       "airpressuredata_hourly", "stationdata_hourly" };
+
+// Value column of each raw table.
+static const char *value_columns[RETENTION_TABLES] = { "temperature", "humidity", "airpressure", "value" };
+
+static QDate partition_start(const QDate &date, RetentionManager::Granularity granularity);
+static QDate partition_end(const QDate &start, RetentionManager::Granularity granularity);
+static QString partition_name(const QDate &start, RetentionManager::Granularity granularity);
+static QString rollup_query(int table, const QString &partition);
+
+RetentionManager::RetentionManager(const QSqlDatabase &source, int raw_days, int rollup_days, bool debugmode)
+/*
+ * Constructor. The connection parameters of the source database are copied,
+ * because a database connection can only be used by the thread that created it.
+ *
+ * in:  source      Database connection to apply the retention to.
+ *      raw_days    Number of days the raw samples are kept (0 = forever).
+ *      rollup_days Number of days the hourly rollups are kept (0 = forever).
+ *      debugmode   Print the actions of each retention run.
+ * out: none
+ */
+{
+    this->connection_name = "retention";
+    this->driver_name = source.driverName();
+    this->host_name = source.hostName();
+    this->database_name = source.databaseName();
+    this->user_name = source.userName();
+    this->password = source.password();
+    this->port = source.port();
+
+    this->raw_days = raw_days;
+    this->rollup_days = rollup_days;
+    this->debugmode = debugmode;
+    this->reclaimed_bytes = 0;
+}
+
+qint64 RetentionManager::ReclaimedBytes() const
+/*
+ * Total storage reclaimed by dropping partitions since the thread was started.
+ *
+ * in:  none
+ * out: Number of bytes (data + index) reclaimed.
+ */
+{
+    return this->reclaimed_bytes.load();
+}
+
+void RetentionManager::run()
+/*
+ * Thread main loop. Applies the retention policy every RETENTION_INTERVAL
+ * seconds until an interruption is requested.
+ *
+ * in:  none
+ * out: none
+ */
+{
+    // Partition management relies on MySQL range partitioning.
+    if(this->driver_name != "QMYSQL")
+        return;
+
+    db = QSqlDatabase::addDatabase(this->driver_name, this->connection_name);
+    db.setHostName(this->host_name);
+    db.setDatabaseName(this->database_name);
+    db.setUserName(this->user_name);
+    db.setPassword(this->password);
+    db.setPort(this->port);
+
+    while(!isInterruptionRequested())
+    {
+        RunRetention();
+
+        for(int i = 0; i < RETENTION_INTERVAL && !isInterruptionRequested(); i++)
+            sleep(1);
+    }
+
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(this->connection_name);
+}
+
+void RetentionManager::RunRetention()
+/*
+ * Perform a single retention run: partition the tables when required, create
+ * the upcoming partitions and drop the partitions that are expired.
+ * The connection is opened per run, so an idle timeout of the server does
+ * not leave the thread with a stale connection.
+ *
+ * in:  none
+ * out: none
+ */
+{
+    QList<Partition> partitions;
+    bool partitioned = false;
+    qint64 reclaimed = 0;
+
+    if(!db.open())
+    {
+        qWarning() << "Retention: unable to open database:" << db.lastError().text();
+        return;
+    }
+
+    for(int i = 0; i < RETENTION_TABLES; i++)
+    {
+        QString raw_table = raw_tables[i];
+        QString rollup_table = rollup_tables[i];
+
+        // The rollup table has to accept the rollups before raw data expires.
+        if(ReadPartitions(rollup_table, &partitions, &partitioned))
+        {
+            if(!partitioned && PartitionTable(rollup_table, MONTHLY))
+                ReadPartitions(rollup_table, &partitions, &partitioned);
+            if(partitioned)
+                AddPartitions(rollup_table, MONTHLY, partitions);
+        }
+
+        if(ReadPartitions(raw_table, &partitions, &partitioned))
+        {
+            if(!partitioned && PartitionTable(raw_table, DAILY))
+                ReadPartitions(raw_table, &partitions, &partitioned);
+            if(partitioned)
+                AddPartitions(raw_table, DAILY, partitions);
+        }
+
+        if(this->raw_days > 0)
+            reclaimed += ExpirePartitions(raw_table, this->raw_days, rollup_table);
+
+        if(this->rollup_days > 0)
+            reclaimed += ExpirePartitions(rollup_table, this->rollup_days, QString());
+    }
+
+    // The camera frames are kept as long as the raw samples, there is no
+    // rollup of a picture.
+    if(ReadPartitions("imageindex", &partitions, &partitioned))
+    {
+        if(!partitioned && PartitionTable("imageindex", DAILY))
+            ReadPartitions("imageindex", &partitions, &partitioned);
+        if(partitioned)
+            AddPartitions("imageindex", DAILY, partitions);
+    }
+
+    if(this->raw_days > 0 && ExpirePartitions("imageindex", this->raw_days, QString()) > 0)
+        DeleteUnusedFrames();
+
+    db.close();
+
+    this->reclaimed_bytes.fetchAndAddRelaxed(reclaimed);
+
+    if(reclaimed > 0 || this->debugmode)
+        qDebug() << "Retention: reclaimed" << reclaimed << "bytes, total"
+                 << this->reclaimed_bytes.load() << "bytes";
+}
+
+bool RetentionManager::ReadPartitions(const QString &table, QList<Partition> *partitions, bool *partitioned)
+/*
+ * Read the partition layout of a table from the information schema.
+ *
+ * in:  table       Name of the table.
+ * out: partitions  Partitions of the table in ascending order.
+ *      partitioned False if the table is not partitioned yet.
+ *      return      False if the layout could not be read.
+ */
+{
+    QSqlQuery query(db);
+
+    partitions->clear();
+    *partitioned = false;
+
+    query.prepare("SELECT PARTITION_NAME, PARTITION_DESCRIPTION, DATA_LENGTH + INDEX_LENGTH "
+                  "FROM information_schema.PARTITIONS "
+                  "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = :table "
+                  "ORDER BY PARTITION_ORDINAL_POSITION");
+    query.bindValue(":table", table);
+
+    if(!query.exec())
+    {
+        qWarning() << "Retention: unable to read partitions of" << table << ":" << query.lastError().text();
+        return false;
+    }
+
+    while(query.next())
+    {
+        Partition partition;
+
+        // A table without partitions is reported as a single NULL partition.
+        if(query.value(0).isNull())
+            return true;
+
+        partition.name = query.value(0).toString();
+        partition.size = query.value(2).toLongLong();
+
+        // Range bounds are stored as TO_DAYS() values or MAXVALUE.
+        bool ok = false;
+        qint64 to_days = query.value(1).toLongLong(&ok);
+        if(ok)
+            partition.end = QDate::fromJulianDay(to_days + TO_DAYS_JULIAN_OFFSET);
+
+        partitions->append(partition);
+        *partitioned = true;
+    }
+
+    return true;
+}
+
+bool RetentionManager::PartitionTable(const QString &table, Granularity granularity)
+/*
+ * Convert an unpartitioned table into a range partitioned table. All existing
+ * data ends up in a single legacy partition which expires as a whole.
+ *
+ * in:  table       Name of the table.
+ *      granularity Partition size (day or month).
+ * out: return      True when the table has been partitioned.
+ */
+{
+    QSqlQuery query(db);
+    QDate start = partition_start(QDate::currentDate(), granularity);
+
+    bool ok = query.exec(QString("ALTER TABLE %1 PARTITION BY RANGE (TO_DAYS(datetime)) ("
+                                 "PARTITION plegacy VALUES LESS THAN (TO_DAYS('%2')), "
+                                 "PARTITION pmax VALUES LESS THAN MAXVALUE)")
+                         .arg(table, start.toString("yyyy-MM-dd")));
+
+    if(!ok)
+        qWarning() << "Retention: unable to partition" << table << ":" << query.lastError().text();
+    else if(this->debugmode)
+        qDebug() << "Retention: partitioned" << table;
+
+    return ok;
+}
+
+bool RetentionManager::AddPartitions(const QString &table, Granularity granularity, const QList<Partition> &partitions)
+/*
+ * Make sure partitions exist for the upcoming RETENTION_PARTITIONS_AHEAD days
+ * or months. The new partitions are split off the (empty) MAXVALUE partition.
+ *
+ * in:  table       Name of the table.
+ *      granularity Partition size (day or month).
+ *      partitions  Current partitions of the table.
+ * out: return      False if the partitions could not be added.
+ */
+{
+    QSqlQuery query(db);
+    QStringList definitions;
+    QDate last_end, horizon;
+
+    foreach(const Partition &partition, partitions)
+    {
+        if(partition.end.isValid())
+            last_end = partition.end;
+    }
+
+    if(!last_end.isValid())
+        return false;
+
+    horizon = partition_start(QDate::currentDate(), granularity);
+    for(int i = 0; i <= RETENTION_PARTITIONS_AHEAD; i++)
+        horizon = partition_end(horizon, granularity);
+
+    // Start at the current partition when the station has been offline for a while.
+    if(last_end < partition_start(QDate::currentDate(), granularity))
+        last_end = partition_start(QDate::currentDate(), granularity);
+
+    while(last_end < horizon)
+    {
+        QDate end = partition_end(last_end, granularity);
+        definitions << QString("PARTITION %1 VALUES LESS THAN (TO_DAYS('%2'))")
+                       .arg(partition_name(last_end, granularity), end.toString("yyyy-MM-dd"));
+        last_end = end;
+    }
+
+    if(definitions.isEmpty())
+        return true;
+
+    definitions << "PARTITION pmax VALUES LESS THAN MAXVALUE";
+
+    bool ok = query.exec(QString("ALTER TABLE %1 REORGANIZE PARTITION pmax INTO (%2)")
+                         .arg(table, definitions.join(", ")));
+
+    if(!ok)
+        qWarning() << "Retention: unable to add partitions to" << table << ":" << query.lastError().text();
+    else if(this->debugmode)
+        qDebug() << "Retention: added" << definitions.size() - 1 << "partitions to" << table;
+
+    return ok;
+}
+
+qint64 RetentionManager::ExpirePartitions(const QString &table, int days, const QString &rollup_table)
+/*
+ * Drop all partitions that only contain data older than the retention period.
+ *
+ * in:  table        Name of the table.
+ *      days         Retention period in days.
+ *      rollup_table Table to summarize the partition into before it is
+ *                   dropped, or empty when no rollup is required.
+ * out: return       Number of bytes reclaimed.
+ */
+{
+    QList<Partition> partitions;
+    bool partitioned = false;
+    qint64 reclaimed = 0;
+    QDate cutoff = QDate::currentDate().addDays(-days);
+
+    if(!ReadPartitions(table, &partitions, &partitioned) || !partitioned)
+        return 0;
+
+    foreach(const Partition &partition, partitions)
+    {
+        QSqlQuery query(db);
+
+        // Partitions are ordered, so the first one that is too recent ends the scan.
+        if(!partition.end.isValid() || partition.end > cutoff)
+            break;
+
+        // Never drop data that could not be summarized.
+        if(!rollup_table.isEmpty() && !RollupPartition(table, rollup_table, partition.name))
+            break;
+
+        if(!query.exec(QString("ALTER TABLE %1 DROP PARTITION %2").arg(table, partition.name)))
+        {
+            qWarning() << "Retention: unable to drop" << table << partition.name << ":" << query.lastError().text();
+            break;
+        }
+
+        reclaimed += partition.size;
+
+        if(this->debugmode)
+            qDebug() << "Retention: dropped" << table << partition.name << "(" << partition.size << "bytes )";
+    }
+
+    return reclaimed;
+}
+
+bool RetentionManager::RollupPartition(const QString &table, const QString &rollup_table, const QString &partition)
+/*
+ * Summarize a raw data partition into hourly minimum, time-weighted average
+ * and maximum values. The hours of a partition are replaced, so a partition
+ * that could not be dropped after its rollup is rolled up again without
+ * duplicates.
+ *
+ * in:  table        Name of the raw data table.
+ *      rollup_table Name of the hourly rollup table.
+ *      partition    Name of the partition to summarize.
+ * out: return       True when the rollup has been stored.
+ */
+{
+    QSqlQuery query(db);
+    QString select;
+
+    for(int i = 0; i < RETENTION_TABLES; i++)
+    {
+        if(table == raw_tables[i])
+            select = rollup_query(i, partition);
+    }
+
+    bool ok = query.exec(QString("REPLACE INTO %1 ").arg(rollup_table) + select);
+
+    if(!ok)
+        qWarning() << "Retention: unable to roll up" << table << partition << ":" << query.lastError().text();
+
+    return ok;
+}
+
+void RetentionManager::DeleteUnusedFrames()
+/*
+ * Delete the frames that are no longer referenced by the image index, i.e.
+ * the frames that were only shown in expired partitions. The frames are not
+ * partitioned, because a frame that does not change is shared by all days.
+ *
+ * in:  none
+ * out: none
+ */
+{
+    QSqlQuery query(db);
+
+    if(!query.exec("DELETE imageframes FROM imageframes "
+                   "LEFT JOIN imageindex ON imageindex.hash = imageframes.hash "
+                   "WHERE imageindex.hash IS NULL"))
+    {
+        qWarning() << "Retention: unable to delete unused frames:" << query.lastError().text();
+        return;
+    }
+
+    if(this->debugmode)
+        qDebug() << "Retention: deleted" << query.numRowsAffected() << "unused frames";
+}
+
+static QDate partition_start(const QDate &date, RetentionManager::Granularity granularity)
+/*
+ * First day of the partition that holds the given date.
+ */
+{
+    if(granularity == RetentionManager::MONTHLY)
+        return QDate(date.year(), date.month(), 1);
+    return date;
+}
+
+static QDate partition_end(const QDate &start, RetentionManager::Granularity granularity)
+/*
+ * First day after the partition that starts at the given date.
+ */
+{
+    if(granularity == RetentionManager::MONTHLY)
+        return start.addMonths(1);
+    return start.addDays(1);
+}
+
+static QString partition_name(const QDate &start, RetentionManager::Granularity granularity)
+/*
+ * Partition name derived from its first day, e.g. p20260131 or p202601.
+ */
+{
+    if(granularity == RetentionManager::MONTHLY)
+        return "p" + start.toString("yyyyMM");
+    return "p" + start.toString("yyyyMMdd");
+}
+
+static QString rollup_query(int table, const QString &partition)
+/*
+ * Hourly summary of a partition of a raw table. The raw tables hold the
+ * vertices of the swinging door compression, which are dense where the
+ * value changes and sparse where it does not, so a plain AVG() would be
+ * biased towards the changes. Instead the series is interpolated linearly
+ * between consecutive rows and every segment is weighted by its duration,
+ * in the hour it starts in. Segments longer than RETENTION_MAX_GAP are an
+ * outage and left out. An hour without any segment (e.g. the last row of
+ * the partition) falls back to the plain average of its rows.
+ */
+{
+    // The fleet table holds a series per station and quantity.
+    bool fleet = (QString(raw_tables[table]) == "stationdata");
+    QString keys = fleet ? "station, quantity, " : "";
+    QString series = fleet ? "PARTITION BY station, quantity " : "";
+    QString hour = "DATE_FORMAT(datetime, '%Y-%m-%d %H:00:00')";
+    QString columns = fleet ? "station, " + hour + ", quantity" : hour;
+    QString groups = fleet ? "1, 2, 3" : "1";
+
+    return QString("SELECT %1, MIN(value), "
+                   "COALESCE(SUM((value + next_value) / 2 * duration) / NULLIF(SUM(duration), 0), AVG(value)), "
+                   "MAX(value), COUNT(*) FROM "
+                   "(SELECT %2datetime, %3 AS value, LEAD(%3) OVER w AS next_value, "
+                   "IF(TIMESTAMPDIFF(SECOND, datetime, LEAD(datetime) OVER w) <= %4, "
+                   "TIMESTAMPDIFF(SECOND, datetime, LEAD(datetime) OVER w), NULL) AS duration "
+                   "FROM %5 PARTITION (%6) WINDOW w AS (%7ORDER BY datetime)) AS segments "
+                   "GROUP BY %8")
+           .arg(columns, keys, value_columns[table], QString::number(RETENTION_MAX_GAP), raw_tables[table],
+                partition, series, groups);
+}
@@ -0,0 +1,74 @@
+#ifndef RETENTIONMANAGER_H
+#define RETENTIONMANAGER_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class expires old weather data in the background. The raw
+ *              data tables are partitioned per day and the hourly rollup tables
+ *              per month, so expired data is removed by dropping whole
+ *              partitions instead of deleting rows.
+ *              The hourly rollups hold the minimum, the time-weighted average
+ *              of the linearly interpolated series and the maximum. The
+ *              samples column counts the stored rows of the hour, which are
+ *              swinging door vertices, not the samples taken by the sensors.
+ *              The rollup relies on window functions (MySQL 8.0, MariaDB 10.2).
+ */
+
+#include <QThread>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QDate>
+#include <QAtomicInteger>
+#include <QDebug>
+
+#define RETENTION_RAW_DAYS          (30)    // days (samples and camera frames), 0 = keep forever
+#define RETENTION_ROLLUP_DAYS       (0)     // days, 0 = keep forever
+#define RETENTION_PARTITIONS_AHEAD  (3)     // partitions created in advance
+#define RETENTION_INTERVAL          (3600)  // seconds between retention runs
+#define RETENTION_MAX_GAP           (1800)  // seconds, longer gaps between rows are outages
+
+class RetentionManager : public QThread
+{
+public:
+    enum Granularity { DAILY, MONTHLY };
+
+    RetentionManager(const QSqlDatabase &source, int raw_days, int rollup_days, bool debugmode);
+
+    qint64 ReclaimedBytes() const;
+
+protected:
+    void run();
+
+private:
+    struct Partition
+    {
+        QString name;
+        QDate   end;        // exclusive upper bound, invalid for MAXVALUE
+        qint64  size;
+    };
+
+    void RunRetention();
+    bool ReadPartitions(const QString &table, QList<Partition> *partitions, bool *partitioned);
+    bool PartitionTable(const QString &table, Granularity granularity);
+    bool AddPartitions(const QString &table, Granularity granularity, const QList<Partition> &partitions);
+    qint64 ExpirePartitions(const QString &table, int days, const QString &rollup_table);
+    bool RollupPartition(const QString &table, const QString &rollup_table, const QString &partition);
+    void DeleteUnusedFrames();
+
+    QSqlDatabase db;
+    QString connection_name;
+    QString driver_name;
+    QString host_name;
+    QString database_name;
+    QString user_name;
+    QString password;
+    int port;
+
+    int raw_days;
+    int rollup_days;
+    bool debugmode;
+    QAtomicInteger<qint64> reclaimed_bytes;
+};
+
+#endif // RETENTIONMANAGER_H
@@ -0,0 +1,68 @@
+#ifndef SENSORFIXTURES_H
+#define SENSORFIXTURES_H
+
+/*
+ * Date:        19-10-2026
+ * Description: Sensor data shared by the benchmark suite and the unit tests,
+ *              so both exercise the decoding with the same inputs: the
+ *              example of the BMP085 datasheet and DHT22 pulse traces.
+ */
+
+#include <QLinkedList>
+#include <math.h>
+#include <stdint.h>
+
+// Calibration EEPROM and raw values of the example in the BMP085 datasheet,
+// which compensate to 699.64 hPa in ultra low power mode.
+static const uint8_t bmp085_eeprom[22] =
+{
+    0x01, 0x98, 0xFF, 0xB8, 0xC7, 0xD1, 0x7F, 0xE5, 0x7F, 0xF5, 0x5A, 0x71,
+    0x18, 0x2E, 0x00, 0x04, 0x80, 0x00, 0xDD, 0xF9, 0x0B, 0x34
+};
+#define BMP085_EXAMPLE_UT   (27898)
+#define BMP085_EXAMPLE_UP   (23843)
+
+static inline void dht22_frame(float temperature, float humidity, int data[5])
+/*
+ * Encode a reading as the 5 bytes sent by the DHT22: humidity and
+ * temperature in tenths (the temperature as sign and magnitude) and the
+ * checksum.
+ */
+{
+    int raw_humidity = (int)lrintf(humidity * 10);
+    int raw_temperature = (int)lrintf(fabsf(temperature) * 10);
+
+    data[0] = raw_humidity >> 8;
+    data[1] = raw_humidity & 0xFF;
+    data[2] = (raw_temperature >> 8) | (temperature < 0 ? 0x80 : 0);
+    data[3] = raw_temperature & 0xFF;
+    data[4] = (data[0] + data[1] + data[2] + data[3]) & 0xFF;
+}
+
+static inline QLinkedList<long> dht22_trace(const int data[5], unsigned int seed)
+/*
+ * Build a DHT22 pulse trace as detect_high_pulses_duration() records it,
+ * with the pulse width jitter seen on a Raspberry Pi.
+ */
+{
+    QLinkedList<long> trace;
+
+    // Host start signal and sensor response
+    trace.append(20000);
+    trace.append(80000);
+
+    for(int i = 0; i < 40; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        long jitter = (long)((seed >> 16) % 8000) - 4000;
+
+        if(data[i / 8] & (0x80 >> (i % 8)))
+            trace.append(70000 + jitter);
+        else
+            trace.append(27000 + jitter);
+    }
+
+    return trace;
+}
+
+#endif // SENSORFIXTURES_H
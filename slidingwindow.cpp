@@ -0,0 +1,293 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class keeps the statistics of a series over a sliding
+ *              time window: mean, minimum, maximum, change and the slope of
+ *              the least squares line. Every statistic is updated in O(1)
+ *              amortized time per sample.
+ *
+ *              The sums for the mean and the regression are updated when a
+ *              sample enters or leaves the window. To bound the rounding
+ *              errors that add up this way, the sums are recomputed relative
+ *              to the oldest sample once as many samples have been added as
+ *              the window holds.
+ *              The minimum and maximum are kept in monotonic deques: a new
+ *              sample removes all samples from the back that can no longer
+ *              become the extreme, the front leaves with its sample.
+ *              Samples and deques are ring buffers, so no memory is
+ *              allocated once the window has reached its size.
+ */
+
+#include "slidingwindow.h"
+
+#define MSEC_PER_HOUR (3600000.0)
+
+SlidingWindow::SlidingWindow(int64_t length)
+/*
+ * Constructor.
+ *
+ * in:  length Length of the window (msec), samples older than the newest
+ *             sample minus the length leave the window.
+ * out: none
+ */
+{
+    this->length = length;
+
+    this->mask = SLIDINGWINDOW_INITIAL_CAPACITY - 1;
+    this->samples = new SlidingWindowSample[this->mask + 1];
+    this->minimum = new uint64_t[this->mask + 1];
+    this->maximum = new uint64_t[this->mask + 1];
+
+    this->first = 0;
+    this->next = 0;
+    this->minimum_first = 0;
+    this->minimum_next = 0;
+    this->maximum_first = 0;
+    this->maximum_next = 0;
+
+    this->origin_time = 0;
+    this->origin_value = 0;
+    this->sum_x = 0;
+    this->sum_y = 0;
+    this->sum_xx = 0;
+    this->sum_xy = 0;
+    this->added = 0;
+}
+
+SlidingWindow::~SlidingWindow()
+{
+    delete[] this->samples;
+    delete[] this->minimum;
+    delete[] this->maximum;
+}
+
+void SlidingWindow::AddSample(int64_t time, float value)
+/*
+ * Add a sample to the window and remove the samples that expire.
+ *
+ * in:  time  Time of the sample (msec), samples older than the newest
+ *            sample in the window are ignored.
+ *      value Value of the sample.
+ * out: none
+ */
+{
+    if(this->next > this->first && time < At(this->next - 1).time)
+        return;
+
+    if(this->next - this->first > this->mask)
+        Grow();
+
+    if(this->next == this->first)
+    {
+        this->origin_time = time;
+        this->origin_value = value;
+    }
+
+    this->samples[this->next & this->mask].time = time;
+    this->samples[this->next & this->mask].value = value;
+
+    double x = (time - this->origin_time) / MSEC_PER_HOUR;
+    double y = value - this->origin_value;
+
+    this->sum_x += x;
+    this->sum_y += y;
+    this->sum_xx += x * x;
+    this->sum_xy += x * y;
+
+    while(this->minimum_next > this->minimum_first &&
+          At(this->minimum[(this->minimum_next - 1) & this->mask]).value >= value)
+        this->minimum_next--;
+    this->minimum[this->minimum_next++ & this->mask] = this->next;
+
+    while(this->maximum_next > this->maximum_first &&
+          At(this->maximum[(this->maximum_next - 1) & this->mask]).value <= value)
+        this->maximum_next--;
+    this->maximum[this->maximum_next++ & this->mask] = this->next;
+
+    this->next++;
+
+    Expire(time);
+
+    if(++this->added >= SLIDINGWINDOW_REBASE && this->added >= Count())
+        Rebase();
+}
+
+int64_t SlidingWindow::Length() const
+/*
+ * Length of the window (msec).
+ */
+{
+    return this->length;
+}
+
+int64_t SlidingWindow::Span() const
+/*
+ * Time between the oldest and the newest sample in the window (msec).
+ */
+{
+    if(this->next == this->first)
+        return 0;
+
+    return At(this->next - 1).time - At(this->first).time;
+}
+
+size_t SlidingWindow::Count() const
+/*
+ * Number of samples in the window.
+ */
+{
+    return (size_t)(this->next - this->first);
+}
+
+double SlidingWindow::Mean() const
+/*
+ * Mean value of the samples in the window, 0 if the window is empty.
+ */
+{
+    if(this->next == this->first)
+        return 0;
+
+    return this->origin_value + this->sum_y / Count();
+}
+
+float SlidingWindow::Minimum() const
+/*
+ * Minimum value in the window, 0 if the window is empty.
+ */
+{
+    if(this->next == this->first)
+        return 0;
+
+    return At(this->minimum[this->minimum_first & this->mask]).value;
+}
+
+float SlidingWindow::Maximum() const
+/*
+ * Maximum value in the window, 0 if the window is empty.
+ */
+{
+    if(this->next == this->first)
+        return 0;
+
+    return At(this->maximum[this->maximum_first & this->mask]).value;
+}
+
+float SlidingWindow::Change() const
+/*
+ * Difference between the newest and the oldest sample in the window, e.g.
+ * the pressure tendency for a three hour window.
+ */
+{
+    if(this->next == this->first)
+        return 0;
+
+    return At(this->next - 1).value - At(this->first).value;
+}
+
+double SlidingWindow::Slope() const
+/*
+ * Slope of the least squares line through the samples in the window.
+ *
+ * in:  none
+ * out: return Rate of change per hour, 0 if it is undetermined.
+ */
+{
+    double n = (double)Count();
+
+    if(n < 2)
+        return 0;
+
+    double variance = this->sum_xx - this->sum_x * this->sum_x / n;
+    double covariance = this->sum_xy - this->sum_x * this->sum_y / n;
+
+    if(variance <= 0)
+        return 0;
+
+    return covariance / variance;
+}
+
+void SlidingWindow::Expire(int64_t time)
+/*
+ * Remove the samples that are older than the window from the sums and the
+ * deques.
+ */
+{
+    while(At(this->first).time < time - this->length)
+    {
+        const SlidingWindowSample &sample = At(this->first);
+        double x = (sample.time - this->origin_time) / MSEC_PER_HOUR;
+        double y = sample.value - this->origin_value;
+
+        this->sum_x -= x;
+        this->sum_y -= y;
+        this->sum_xx -= x * x;
+        this->sum_xy -= x * y;
+
+        if(this->minimum[this->minimum_first & this->mask] == this->first)
+            this->minimum_first++;
+        if(this->maximum[this->maximum_first & this->mask] == this->first)
+            this->maximum_first++;
+
+        this->first++;
+    }
+}
+
+void SlidingWindow::Grow()
+/*
+ * Double the capacity of the ring buffers.
+ */
+{
+    uint64_t mask = this->mask * 2 + 1;
+    SlidingWindowSample *samples = new SlidingWindowSample[mask + 1];
+    uint64_t *minimum = new uint64_t[mask + 1];
+    uint64_t *maximum = new uint64_t[mask + 1];
+
+    for(uint64_t i = this->first; i != this->next; i++)
+        samples[i & mask] = this->samples[i & this->mask];
+    for(uint64_t i = this->minimum_first; i != this->minimum_next; i++)
+        minimum[i & mask] = this->minimum[i & this->mask];
+    for(uint64_t i = this->maximum_first; i != this->maximum_next; i++)
+        maximum[i & mask] = this->maximum[i & this->mask];
+
+    delete[] this->samples;
+    delete[] this->minimum;
+    delete[] this->maximum;
+
+    this->samples = samples;
+    this->minimum = minimum;
+    this->maximum = maximum;
+    this->mask = mask;
+}
+
+void SlidingWindow::Rebase()
+/*
+ * Recompute the sums relative to the oldest sample in the window.
+ */
+{
+    this->origin_time = At(this->first).time;
+    this->origin_value = At(this->first).value;
+    this->sum_x = 0;
+    this->sum_y = 0;
+    this->sum_xx = 0;
+    this->sum_xy = 0;
+
+    for(uint64_t i = this->first; i != this->next; i++)
+    {
+        double x = (At(i).time - this->origin_time) / MSEC_PER_HOUR;
+        double y = At(i).value - this->origin_value;
+
+        this->sum_x += x;
+        this->sum_y += y;
+        this->sum_xx += x * x;
+        this->sum_xy += x * y;
+    }
+
+    this->added = 0;
+}
+
+const SlidingWindowSample &SlidingWindow::At(uint64_t index) const
+/*
+ * Sample number index, which must be in the window.
+ */
+{
+    return this->samples[index & this->mask];
+}
@@ -0,0 +1,80 @@
+#ifndef SLIDINGWINDOW_H
+#define SLIDINGWINDOW_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class keeps the statistics of a series over a sliding
+ *              time window: mean, minimum, maximum, change and the slope of
+ *              the least squares line. Every statistic is updated in O(1)
+ *              amortized time per sample.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SLIDINGWINDOW_INITIAL_CAPACITY  (64)    // samples, grows when needed
+#define SLIDINGWINDOW_REBASE            (16)    // minimum samples between recomputations of the sums
+
+struct SlidingWindowSample
+{
+    int64_t time;   // msec since epoch
+    float value;
+};
+
+class SlidingWindow
+{
+public:
+    SlidingWindow(int64_t length);
+    ~SlidingWindow();
+
+    void AddSample(int64_t time, float value);
+
+    int64_t Length() const;
+    int64_t Span() const;
+    size_t Count() const;
+
+    double Mean() const;
+    float Minimum() const;
+    float Maximum() const;
+    float Change() const;
+    double Slope() const;
+
+private:
+    SlidingWindow(const SlidingWindow &);
+    SlidingWindow &operator=(const SlidingWindow &);
+
+    void Expire(int64_t time);
+    void Grow();
+    void Rebase();
+
+    const SlidingWindowSample &At(uint64_t index) const;
+
+    int64_t length;
+
+    // Samples in the window, sample n is stored at n & mask.
+    SlidingWindowSample *samples;
+    uint64_t first;
+    uint64_t next;
+    uint64_t mask;
+
+    // Monotonic deques of sample numbers, the front holds the minimum
+    // respectively maximum of the window.
+    uint64_t *minimum;
+    uint64_t minimum_first;
+    uint64_t minimum_next;
+    uint64_t *maximum;
+    uint64_t maximum_first;
+    uint64_t maximum_next;
+
+    // Sums for the mean and the regression, relative to an origin to keep
+    // the precision. Time in hours.
+    int64_t origin_time;
+    float origin_value;
+    double sum_x;
+    double sum_y;
+    double sum_xx;
+    double sum_xy;
+    uint64_t added;
+};
+
+#endif // SLIDINGWINDOW_H
@@ -0,0 +1,242 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class derives forecast-style signals from the live
+ *              samples: rolling statistics over several windows per
+ *              quantity, the pressure tendency and threshold alerts.
+ *
+ *              Every quantity is tracked over all windows at once, see
+ *              SlidingWindow, so the signals are available as soon as a
+ *              sample is taken instead of by querying the database.
+ *              An alert is raised when its measure crosses the threshold and
+ *              cleared when it falls back below the threshold minus the
+ *              hysteresis, so a measure around the threshold does not flood
+ *              the subscribers with alerts.
+ */
+
+#include "streamanalytics.h"
+#include <QJsonArray>
+
+enum Measure
+{
+    MEASURE_CHANGE,
+    MEASURE_SLOPE,
+    MEASURE_MINIMUM
+};
+
+struct AlertRule
+{
+    const char *name;
+    WeatherQuantity quantity;
+    int window;
+    Measure measure;
+    double direction;   // -1 for alerts on falling values
+    double threshold;   // of direction * measure
+    double hysteresis;
+};
+
+static const int64_t window_lengths[ANALYTICS_WINDOW_COUNT] =
+{
+    10 * 60 * 1000LL, 60 * 60 * 1000LL, 3 * 60 * 60 * 1000LL, 24 * 60 * 60 * 1000LL
+};
+
+static const char *window_names[ANALYTICS_WINDOW_COUNT] = { "10m", "1h", "3h", "24h" };
+
+static const char *quantity_names[QUANTITY_COUNT] = { "temperature", "humidity", "airpressure" };
+
+static const AlertRule alert_rules[StreamAnalytics::ALERT_COUNT] =
+{
+    { "pressure_falling", QUANTITY_AIRPRESSURE, ANALYTICS_WINDOW_3H, MEASURE_CHANGE, -1,
+      ANALYTICS_PRESSURE_CHANGE, ANALYTICS_PRESSURE_HYST },
+    { "pressure_rising", QUANTITY_AIRPRESSURE, ANALYTICS_WINDOW_3H, MEASURE_CHANGE, 1,
+      ANALYTICS_PRESSURE_CHANGE, ANALYTICS_PRESSURE_HYST },
+    { "temperature_falling", QUANTITY_TEMPERATURE, ANALYTICS_WINDOW_1H, MEASURE_SLOPE, -1,
+      ANALYTICS_TEMPERATURE_RATE, ANALYTICS_TEMPERATURE_HYST },
+    { "temperature_rising", QUANTITY_TEMPERATURE, ANALYTICS_WINDOW_1H, MEASURE_SLOPE, 1,
+      ANALYTICS_TEMPERATURE_RATE, ANALYTICS_TEMPERATURE_HYST },
+    { "frost", QUANTITY_TEMPERATURE, ANALYTICS_WINDOW_10M, MEASURE_MINIMUM, -1,
+      -ANALYTICS_FROST, ANALYTICS_FROST_HYST }
+};
+
+StreamAnalytics::StreamAnalytics()
+/*
+ * Constructor.
+ */
+{
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+        for(int w = 0; w < ANALYTICS_WINDOW_COUNT; w++)
+            this->windows[q][w] = new SlidingWindow(window_lengths[w]);
+
+    for(int i = 0; i < ALERT_COUNT; i++)
+        this->active[i] = false;
+}
+
+StreamAnalytics::~StreamAnalytics()
+{
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+        for(int w = 0; w < ANALYTICS_WINDOW_COUNT; w++)
+            delete this->windows[q][w];
+}
+
+quint32 StreamAnalytics::AddSample(WeatherQuantity quantity, int64_t time, float value)
+/*
+ * Add a sample to all windows of its quantity and evaluate the alerts on
+ * that quantity.
+ *
+ * in:  quantity Quantity of the sample.
+ *      time     Time of the sample (msec since epoch).
+ *      value    Value of the sample.
+ * out: return   Bit (1 << alert) set for every alert that was raised or
+ *               cleared by this sample.
+ */
+{
+    quint32 changed = 0;
+
+    for(int w = 0; w < ANALYTICS_WINDOW_COUNT; w++)
+        this->windows[quantity][w]->AddSample(time, value);
+
+    for(int i = 0; i < ALERT_COUNT; i++)
+    {
+        const AlertRule &rule = alert_rules[i];
+        const SlidingWindow *window = this->windows[rule.quantity][rule.window];
+
+        if(rule.quantity != quantity || window->Span() < window->Length() * ANALYTICS_MIN_COVERAGE)
+            continue;
+
+        double measure = Measure((Alert)i);
+
+        if(!this->active[i] && measure >= rule.threshold)
+        {
+            this->active[i] = true;
+            changed |= 1 << i;
+        }
+        else if(this->active[i] && measure < rule.threshold - rule.hysteresis)
+        {
+            this->active[i] = false;
+            changed |= 1 << i;
+        }
+    }
+
+    return changed;
+}
+
+const SlidingWindow &StreamAnalytics::Window(WeatherQuantity quantity, int window) const
+/*
+ * Statistics of a quantity over one of the windows (ANALYTICS_WINDOW_*).
+ */
+{
+    return *this->windows[quantity][window];
+}
+
+float StreamAnalytics::PressureTendency() const
+/*
+ * Change of the air pressure over the last 3 hours (hPa).
+ */
+{
+    return this->windows[QUANTITY_AIRPRESSURE][ANALYTICS_WINDOW_3H]->Change();
+}
+
+bool StreamAnalytics::IsActive(Alert alert) const
+/*
+ * Whether an alert is raised.
+ */
+{
+    return this->active[alert];
+}
+
+QJsonObject StreamAnalytics::ToJson(int64_t time) const
+/*
+ * All derived signals as a JSON object.
+ *
+ * in:  time   Time of the latest sample (msec since epoch).
+ * out: return {"time", "<quantity>": {"<window>": {"count", "mean",
+ *             "minimum", "maximum", "change", "slope"}, ...}, ...,
+ *             "pressure_tendency", "alerts": [...]}
+ */
+{
+    QJsonObject object;
+    QJsonArray alerts;
+
+    object["time"] = (double)time;
+
+    for(int q = 0; q < QUANTITY_COUNT; q++)
+    {
+        QJsonObject quantity;
+
+        for(int w = 0; w < ANALYTICS_WINDOW_COUNT; w++)
+        {
+            const SlidingWindow *window = this->windows[q][w];
+            QJsonObject statistics;
+
+            if(window->Count() == 0)
+                continue;
+
+            statistics["count"] = (int)window->Count();
+            statistics["mean"] = window->Mean();
+            statistics["minimum"] = window->Minimum();
+            statistics["maximum"] = window->Maximum();
+            statistics["change"] = window->Change();
+            statistics["slope"] = window->Slope();
+            quantity[window_names[w]] = statistics;
+        }
+
+        object[quantity_names[q]] = quantity;
+    }
+
+    object["pressure_tendency"] = PressureTendency();
+
+    for(int i = 0; i < ALERT_COUNT; i++)
+        if(this->active[i])
+            alerts.append(AlertName((Alert)i));
+    object["alerts"] = alerts;
+
+    return object;
+}
+
+QJsonObject StreamAnalytics::AlertToJson(Alert alert, int64_t time) const
+/*
+ * The state of an alert as a JSON object.
+ *
+ * in:  alert  Alert.
+ *      time   Time of the sample that changed the alert (msec since epoch).
+ * out: return {"time", "alert", "active", "value", "threshold"}
+ */
+{
+    const AlertRule &rule = alert_rules[alert];
+    QJsonObject object;
+
+    object["time"] = (double)time;
+    object["alert"] = AlertName(alert);
+    object["active"] = this->active[alert];
+    object["value"] = rule.direction * Measure(alert);
+    object["threshold"] = rule.direction * rule.threshold;
+
+    return object;
+}
+
+QString StreamAnalytics::AlertName(Alert alert)
+/*
+ * Name of an alert, e.g. "pressure_falling".
+ */
+{
+    return alert_rules[alert].name;
+}
+
+double StreamAnalytics::Measure(Alert alert) const
+/*
+ * Measure of an alert, multiplied by its direction so that a larger value
+ * always means closer to raising the alert.
+ */
+{
+    const AlertRule &rule = alert_rules[alert];
+    const SlidingWindow *window = this->windows[rule.quantity][rule.window];
+
+    switch(rule.measure)
+    {
+    case MEASURE_CHANGE:
+        return rule.direction * window->Change();
+    case MEASURE_SLOPE:
+        return rule.direction * window->Slope();
+    default:
+        return rule.direction * window->Minimum();
+    }
+}
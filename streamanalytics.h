@@ -0,0 +1,64 @@
+#ifndef STREAMANALYTICS_H
+#define STREAMANALYTICS_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class derives forecast-style signals from the live
+ *              samples: rolling statistics over several windows per
+ *              quantity, the pressure tendency and threshold alerts.
+ */
+
+#include <QJsonObject>
+#include <QString>
+#include <slidingwindow.h>
+#include <weatherdatabase.h>
+
+#define ANALYTICS_WINDOW_COUNT      (4)     // 10 minutes, 1 hour, 3 hours, 24 hours
+#define ANALYTICS_WINDOW_10M        (0)
+#define ANALYTICS_WINDOW_1H         (1)
+#define ANALYTICS_WINDOW_3H         (2)
+#define ANALYTICS_WINDOW_24H        (3)
+#define ANALYTICS_MIN_COVERAGE      (0.9)   // part of a window that must hold samples before it raises alerts
+
+// Alert thresholds
+#define ANALYTICS_PRESSURE_CHANGE   (3.6)   // hPa in 3 hours, "falling/rising quickly"
+#define ANALYTICS_PRESSURE_HYST     (0.5)   // hPa
+#define ANALYTICS_TEMPERATURE_RATE  (3.0)   // degrees celcius per hour
+#define ANALYTICS_TEMPERATURE_HYST  (0.5)   // degrees celcius per hour
+#define ANALYTICS_FROST             (0.0)   // degrees celcius
+#define ANALYTICS_FROST_HYST        (0.5)   // degrees celcius
+
+class StreamAnalytics
+{
+public:
+    enum Alert
+    {
+        ALERT_PRESSURE_FALLING,
+        ALERT_PRESSURE_RISING,
+        ALERT_TEMPERATURE_FALLING,
+        ALERT_TEMPERATURE_RISING,
+        ALERT_FROST,
+        ALERT_COUNT
+    };
+
+    StreamAnalytics();
+    ~StreamAnalytics();
+
+    quint32 AddSample(WeatherQuantity quantity, int64_t time, float value);
+
+    const SlidingWindow &Window(WeatherQuantity quantity, int window) const;
+    float PressureTendency() const;
+    bool IsActive(Alert alert) const;
+
+    QJsonObject ToJson(int64_t time) const;
+    QJsonObject AlertToJson(Alert alert, int64_t time) const;
+    static QString AlertName(Alert alert);
+
+private:
+    double Measure(Alert alert) const;
+
+    SlidingWindow *windows[QUANTITY_COUNT][ANALYTICS_WINDOW_COUNT];
+    bool active[ALERT_COUNT];
+};
+
+#endif // STREAMANALYTICS_H
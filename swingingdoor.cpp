@@ -0,0 +1,166 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class implements swinging door compression of a series
+ *              of samples. Only the samples needed to reconstruct the series
+ *              by linear interpolation within a given tolerance are emitted.
+ *
+ *              The door is made up of the range of slopes, starting at the
+ *              last archived sample, for which a straight line passes all
+ *              intermediate samples within the tolerance. A new sample can
+ *              end the current line as long as its slope lies within the
+ *              door. Otherwise the previous sample is archived and a new
+ *              line starts there. Every sample between two archived samples
+ *              therefore lies within the tolerance of the interpolated line.
+ */
+
+#include "swingingdoor.h"
+#include <float.h>
+
+SwingingDoor::SwingingDoor(float tolerance, int64_t max_interval)
+/*
+ * Constructor.
+ *
+ * in:  tolerance    Maximum deviation of the reconstructed series.
+ *      max_interval Maximum time between two emitted samples (msec).
+ * out: none
+ */
+{
+    this->tolerance = tolerance;
+    this->max_interval = max_interval;
+
+    this->has_archived = false;
+    this->has_held = false;
+
+    this->lower_slope = -DBL_MAX;
+    this->upper_slope = DBL_MAX;
+
+    this->received = 0;
+    this->emitted = 0;
+}
+
+int SwingingDoor::AddSample(const SwingingDoorSample &sample, SwingingDoorSample *output)
+/*
+ * Feed a new sample to the compressor. Samples are emitted one sample late,
+ * because whether a sample is needed depends on the samples that follow.
+ *
+ * in:  sample Sample to compress, time must be increasing.
+ * out: output Samples to store (at most SWINGINGDOOR_MAX_OUTPUT).
+ *      return Number of samples written to output.
+ */
+{
+    int count = 0;
+
+    this->received++;
+
+    if(!this->has_archived)
+    {
+        Archive(sample);
+        output[count++] = sample;
+        return count;
+    }
+
+    if(this->has_held)
+    {
+        double dt = this->held.time - this->archived.time;
+        double lower = this->lower_slope;
+        double upper = this->upper_slope;
+        bool in_door = false;
+
+        // Narrow the door with the held sample, it becomes an intermediate
+        // sample when the new sample ends the line.
+        if(dt > 0)
+        {
+            double held_lower = (this->held.value - this->tolerance - this->archived.value) / dt;
+            double held_upper = (this->held.value + this->tolerance - this->archived.value) / dt;
+
+            if(held_lower > lower)
+                lower = held_lower;
+            if(held_upper < upper)
+                upper = held_upper;
+
+            dt = sample.time - this->archived.time;
+            if(dt > 0)
+            {
+                double slope = (sample.value - this->archived.value) / dt;
+                in_door = (slope >= lower && slope <= upper);
+            }
+        }
+
+        if(in_door && (sample.time - this->archived.time) <= this->max_interval)
+        {
+            this->lower_slope = lower;
+            this->upper_slope = upper;
+            this->held = sample;
+            return count;
+        }
+
+        // The door closed (or the heartbeat expired), archive the held sample.
+        Archive(this->held);
+        output[count++] = this->held;
+    }
+
+    // Emit directly after a gap longer than the heartbeat interval.
+    if((sample.time - this->archived.time) > this->max_interval)
+    {
+        Archive(sample);
+        output[count++] = sample;
+        return count;
+    }
+
+    this->held = sample;
+    this->has_held = true;
+
+    return count;
+}
+
+int SwingingDoor::Flush(SwingingDoorSample *output)
+/*
+ * Emit the held sample, e.g. when acquisition stops.
+ *
+ * in:  none
+ * out: output Sample to store.
+ *      return Number of samples written to output.
+ */
+{
+    if(!this->has_held)
+        return 0;
+
+    Archive(this->held);
+    output[0] = this->archived;
+
+    return 1;
+}
+
+long SwingingDoor::Received() const
+/*
+ * Number of samples fed to the compressor.
+ */
+{
+    return this->received;
+}
+
+long SwingingDoor::Emitted() const
+/*
+ * Number of samples emitted by the compressor.
+ */
+{
+    return this->emitted;
+}
+
+void SwingingDoor::Archive(const SwingingDoorSample &sample)
+/*
+ * Start a new line at the given sample and open the door completely.
+ *
+ * in:  sample Sample that is emitted.
+ * out: none
+ */
+{
+    this->archived = sample;
+    this->has_archived = true;
+    this->has_held = false;
+
+    this->lower_slope = -DBL_MAX;
+    this->upper_slope = DBL_MAX;
+
+    this->emitted++;
+}
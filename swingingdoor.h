@@ -0,0 +1,50 @@
+#ifndef SWINGINGDOOR_H
+#define SWINGINGDOOR_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class implements swinging door compression of a series
+ *              of samples. Only the samples needed to reconstruct the series
+ *              by linear interpolation within a given tolerance are emitted.
+ */
+
+#include <stdint.h>
+
+#define SWINGINGDOOR_MAX_OUTPUT (2)
+
+struct SwingingDoorSample
+{
+    int64_t time;   // msec since epoch
+    float value;
+};
+
+class SwingingDoor
+{
+public:
+    SwingingDoor(float tolerance, int64_t max_interval);
+
+    int AddSample(const SwingingDoorSample &sample, SwingingDoorSample *output);
+    int Flush(SwingingDoorSample *output);
+
+    long Received() const;
+    long Emitted() const;
+
+private:
+    void Archive(const SwingingDoorSample &sample);
+
+    float tolerance;
+    int64_t max_interval;
+
+    SwingingDoorSample archived;
+    SwingingDoorSample held;
+    bool has_archived;
+    bool has_held;
+
+    double lower_slope;
+    double upper_slope;
+
+    long received;
+    long emitted;
+};
+
+#endif // SWINGINGDOOR_H
@@ -3,10 +3,18 @@
  * Date:        24-01-2014
  * Description: This class offers functionality add the temperature, humidity
  *              and air pressure to the mysql database.
+ *              In client mode the samples are sent to an ingest server in
+ *              batches instead (see ingestprotocol.h).
  */
 
 #include "weatherdatabase.h"
 #include <QSqlError>
+#include <QHostInfo>
+#include <limits.h>
+
+static const char *quantity_tables[QUANTITY_COUNT] = { "temperaturedata", "humiditydata", "airpressuredata" };
+static const char *rollup_tables[QUANTITY_COUNT] = { "temperaturedata_hourly", "humiditydata_hourly", "airpressuredata_hourly" };
+static const char *quantity_columns[QUANTITY_COUNT] = { "temperature", "humidity", "airpressure" };
 
 WeatherDatabase::WeatherDatabase()
 /*
@@ -24,33 +32,78 @@ WeatherDatabase::WeatherDatabase()
     db.setPassword("0b704a62");
 
     this->database_opened = false;
+
+    this->ingest_socket = NULL;
+    this->ingest_port = INGEST_PORT;
+    this->station = 0;
+    this->next_sequence = 0;
+}
+
+WeatherDatabase::WeatherDatabase(const QString &driver, const QString &databasename)
+/*
+ * Constructor for a local database, e.g. a "QSQLITE" database file for
+ * benchmarks and bulk operations.
+ *
+ * in:  driver        Qt database driver.
+ *      databasename  Name of the database (file name for "QSQLITE").
+ * out: none
+ */
+{
+    this->db = QSqlDatabase::addDatabase(driver);
+    db.setDatabaseName(databasename);
+
+    this->database_opened = false;
+
+    this->ingest_socket = NULL;
+    this->ingest_port = INGEST_PORT;
+    this->station = 0;
+    this->next_sequence = 0;
 }
 
-void WeatherDatabase::OpenDatabase()
+bool WeatherDatabase::OpenDatabase()
 /*
  * Open the weatherdatabase. A new database with corresponsing tables will be
  * created if these do not exist.
  *
  * in:  none
- * out: none
+ * out: return  False if the database could not be opened (or in client mode
+ *              the ingest server could not be resolved).
  */
 {
+    // In client mode no database connection is made at all.
+    if(!this->ingest_host.isEmpty())
+    {
+        QHostInfo info = QHostInfo::fromName(this->ingest_host);
+
+        if(info.addresses().isEmpty())
+        {
+            qWarning() << "Unable to resolve ingest server" << this->ingest_host;
+            return false;
+        }
+
+        this->ingest_address = info.addresses().first();
+        this->ingest_socket = new QUdpSocket();
+        this->ingest_socket->bind();
+        return true;
+    }
+
     // Open the "QMYSQL" database, this makes sure a initial database object
     // can be opened to check for the existence of the weatherdatabase.
     bool ok = db.open();
 
     if(ok)
     {
-        QSqlQuery query;
-
         // Create required tables if not existing.
-        query.exec("CREATE TABLE IF NOT EXISTS temperaturedata (datetime DATETIME, temperature FLOAT)");
-        query.exec("CREATE TABLE IF NOT EXISTS humiditydata (datetime DATETIME, humidity FLOAT)");
-        query.exec("CREATE TABLE IF NOT EXISTS airpressuredata (datetime DATETIME, airpressure FLOAT)");
-        query.exec("CREATE TABLE IF NOT EXISTS imagedata (id SMALLINT, image LONGBLOB, PRIMARY KEY (id))");
+        CreateTables();
 
         this->database_opened = true;
     }
+    else
+    {
+        qWarning() << "Unable to open database:" << db.lastError().text();
+    }
+
+    return ok;
 }
 
 void WeatherDatabase::CloseDatabase()
@@ -61,95 +114,502 @@ void WeatherDatabase::CloseDatabase()
  * out: none
  */
 {
+    if(this->ingest_socket != NULL)
+    {
+        Flush();
+        delete this->ingest_socket;
+        this->ingest_socket = NULL;
+    }
+
     db.close();
     this->database_opened = false;
 }
 
-void WeatherDatabase::AddTemperatureData(float temperature)
+void WeatherDatabase::AddTemperatureData(float temperature, const QDateTime &datetime)
 /*
  * Add temperature data to the weatherdatabase.
  * Also stores the date and time
  *
  * in:  temperature  Temperature collected from sensor.
+ *      datetime     Date and time the temperature was collected.
  * out: none
  */
 {
     QSqlQuery query;
 
+    if(this->ingest_socket != NULL)
+    {
+        QueueIngestRecord(QUANTITY_TEMPERATURE, temperature, datetime);
+        return;
+    }
+
     if(this->database_opened)
     {
         query.prepare("INSERT INTO temperaturedata "
-                      "VALUES (NOW(), :temperature)");
+                      "VALUES (:datetime, :temperature)");
+        query.bindValue(":datetime", datetime);
         query.bindValue(":temperature", temperature);
         query.exec();
     }
 }
 
-void WeatherDatabase::AddHumidityData(float humidity)
+void WeatherDatabase::AddHumidityData(float humidity, const QDateTime &datetime)
 /*
  * Add humidity data to the weatherdatabase.
  * Also stores the date and time
  *
  * in:  humidity  Humidity collected from sensor.
+ *      datetime  Date and time the humidity was collected.
  * out: none
  */
 {
     QSqlQuery query;
 
+    if(this->ingest_socket != NULL)
+    {
+        QueueIngestRecord(QUANTITY_HUMIDITY, humidity, datetime);
+        return;
+    }
+
     if(this->database_opened)
     {
         query.prepare("INSERT INTO humiditydata "
-                      "VALUES (NOW(), :humidity)");
+                      "VALUES (:datetime, :humidity)");
+        query.bindValue(":datetime", datetime);
         query.bindValue(":humidity", humidity);
         query.exec();
     }
 }
 
-void WeatherDatabase::AddAirpressureData(float airpressure)
+void WeatherDatabase::AddAirpressureData(float airpressure, const QDateTime &datetime)
 /*
  * Add air pressure data to the weatherdatabase.
  * Also stores the date and time
  *
  * in:  airpressure  Airpressure collected from sensor.
+ *      datetime     Date and time the airpressure was collected.
  * out: none
  */
 {
     QSqlQuery query;
 
+    if(this->ingest_socket != NULL)
+    {
+        QueueIngestRecord(QUANTITY_AIRPRESSURE, airpressure, datetime);
+        return;
+    }
+
     if(this->database_opened)
     {
         query.prepare("INSERT INTO airpressuredata "
-                      "VALUES (NOW(), :airpressure)");
+                      "VALUES (:datetime, :airpressure)");
+        query.bindValue(":datetime", datetime);
         query.bindValue(":airpressure", airpressure);
         query.exec();
     }
 }
 
-void WeatherDatabase::AddImageData(char* imagepath)
+void WeatherDatabase::AddData(WeatherQuantity quantity, float value, const QDateTime &datetime)
 /*
- * Add image data to the weatherdatabase.
+ * Add data of the given quantity to the weatherdatabase.
  *
- * in:  imagepath  Path to image.
+ * in:  quantity  Quantity the value belongs to.
+ *      value     Value collected from sensor.
+ *      datetime  Date and time the value was collected.
  * out: none
  */
+{
+    switch(quantity)
+    {
+    case QUANTITY_TEMPERATURE:
+        AddTemperatureData(value, datetime);
+        break;
+    case QUANTITY_HUMIDITY:
+        AddHumidityData(value, datetime);
+        break;
+    case QUANTITY_AIRPRESSURE:
+        AddAirpressureData(value, datetime);
+        break;
+    default:
+        break;
+    }
+}
+
+bool WeatherDatabase::AddImageData(const QByteArray &image, const QByteArray &hash, const QDateTime &datetime)
+/*
+ * Add image data to the weatherdatabase. Frames are stored once per content
+ * hash, the time index records from when a frame was shown by the camera.
+ * The latest frame is also kept in the imagedata table for existing clients.
+ *
+ * in:  image     JPEG encoded frame.
+ *      hash      Content hash of the frame.
+ *      datetime  Date and time the frame was taken.
+ * out: return    True if the frame has been stored.
+ */
 {
     QSqlQuery query;
 
-    QByteArray bytearray;
-    QFile f(imagepath);
+    if(!this->database_opened)
+        return false;
 
-    if(f.open(QIODevice::ReadOnly))
+    if(!db.transaction())
+        return false;
+
+    // A frame that is stored already (e.g. by a concurrent writer) is
+    // ignored by the primary key, without a separate lookup.
+    if(db.driverName() == "QSQLITE")
+        query.prepare("INSERT OR IGNORE INTO imageframes "
+                      "VALUES (:hash, :image)");
+    else
+        query.prepare("INSERT IGNORE INTO imageframes "
+                      "VALUES (:hash, :image)");
+    query.bindValue(":hash", hash);
+    query.bindValue(":image", image);
+    bool ok = query.exec();
+
+    if(ok)
     {
-        bytearray = f.readAll();
-        f.close();
+        query.prepare("INSERT INTO imageindex "
+                      "VALUES (:datetime, :hash)");
+        query.bindValue(":datetime", datetime);
+        query.bindValue(":hash", hash);
+        ok = query.exec();
     }
 
-    if(this->database_opened)
+    if(ok)
     {
         query.prepare("REPLACE INTO imagedata "
                       "VALUES (0, :image)");
-        query.bindValue(":image", bytearray);
-        query.exec();
+        query.bindValue(":image", image);
+        ok = query.exec();
+    }
+
+    if(!ok)
+    {
+        qWarning() << "Unable to store image:" << query.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    return db.commit();
+}
+
+bool WeatherDatabase::AddStationData(const QVector<StationSample> &samples)
+/*
+ * Add the samples of a fleet of stations to the weatherdatabase in a single
+ * transaction, using multi-row inserts of INSERT_BATCH_ROWS rows.
+ *
+ * in:  samples  Samples received from the stations.
+ * out: return   True if all samples have been stored.
+ */
+{
+    QSqlQuery query;
+    int prepared_rows = 0;
+    int batch_rows = INSERT_BATCH_ROWS;
+
+    if(!this->database_opened)
+        return false;
+
+    // SQLite limits the number of parameters of a statement.
+    if(db.driverName() == "QSQLITE")
+        batch_rows = SQLITE_MAX_PARAMS / 4;
+
+    if(!db.transaction())
+        return false;
+
+    for(int first = 0; first < samples.size(); first += batch_rows)
+    {
+        int rows = qMin(batch_rows, samples.size() - first);
+
+        // Only the last statement can have a different number of rows.
+        if(rows != prepared_rows)
+        {
+            QString statement = "INSERT INTO stationdata VALUES (?, ?, ?, ?)";
+            for(int i = 1; i < rows; i++)
+                statement += ", (?, ?, ?, ?)";
+            query.prepare(statement);
+            prepared_rows = rows;
+        }
+
+        for(int i = first; i < first + rows; i++)
+        {
+            query.addBindValue(samples[i].station);
+            query.addBindValue(QDateTime::fromMSecsSinceEpoch(samples[i].time));
+            query.addBindValue(samples[i].quantity);
+            query.addBindValue(samples[i].value);
+        }
+
+        if(!query.exec())
+        {
+            qWarning() << "Unable to store station data:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    return db.commit();
+}
+
+bool WeatherDatabase::AddBulkData(const QVector<StationSample> &samples)
+/*
+ * Add samples of this station to the tables of their quantities in a single
+ * transaction, using multi-row inserts. Used to import history in bulk.
+ *
+ * in:  samples  Samples to store, the station is ignored.
+ * out: return   True if all samples have been stored.
+ */
+{
+    QSqlQuery query;
+    int batch_rows = INSERT_BATCH_ROWS;
+
+    if(!this->database_opened)
+        return false;
+
+    // SQLite limits the number of parameters of a statement.
+    if(db.driverName() == "QSQLITE")
+        batch_rows = SQLITE_MAX_PARAMS / 2;
+
+    if(!db.transaction())
+        return false;
+
+    for(int quantity = 0; quantity < QUANTITY_COUNT; quantity++)
+    {
+        QVector<int> rows;
+        int prepared_rows = 0;
+
+        for(int i = 0; i < samples.size(); i++)
+            if(samples[i].quantity == quantity)
+                rows.append(i);
+
+        for(int first = 0; first < rows.size(); first += batch_rows)
+        {
+            int count = qMin(batch_rows, rows.size() - first);
+
+            // Only the last statement can have a different number of rows.
+            if(count != prepared_rows)
+            {
+                QString statement = QString("INSERT INTO %1 VALUES (?, ?)").arg(quantity_tables[quantity]);
+                for(int i = 1; i < count; i++)
+                    statement += ", (?, ?)";
+                query.prepare(statement);
+                prepared_rows = count;
+            }
+
+            for(int i = first; i < first + count; i++)
+            {
+                query.addBindValue(QDateTime::fromMSecsSinceEpoch(samples[rows[i]].time));
+                query.addBindValue(samples[rows[i]].value);
+            }
+
+            if(!query.exec())
+            {
+                qWarning() << "Unable to store bulk data:" << query.lastError().text();
+                db.rollback();
+                return false;
+            }
+        }
+    }
+
+    return db.commit();
+}
+
+bool WeatherDatabase::ReadSampleRange(WeatherQuantity quantity, qint64 *first, qint64 *last)
+/*
+ * Get the time range of the stored samples of a quantity.
+ *
+ * in:  quantity  Quantity of the samples.
+ * out: first     Time of the oldest sample (msec since epoch), LLONG_MAX if
+ *                there are no samples.
+ *      last      Time of the newest sample (msec since epoch), LLONG_MIN if
+ *                there are no samples.
+ *      return    False if the samples could not be read.
+ */
+{
+    return ReadTableRange(quantity_tables[quantity], first, last);
+}
+
+bool WeatherDatabase::ReadRollupRange(WeatherQuantity quantity, qint64 *first, qint64 *last)
+/*
+ * Get the time range of the hourly rollups of a quantity, see
+ * ReadSampleRange().
+ */
+{
+    return ReadTableRange(rollup_tables[quantity], first, last);
+}
+
+bool WeatherDatabase::ReadSampleTimes(WeatherQuantity quantity, qint64 from, qint64 to, QSet<qint64> *times)
+/*
+ * Get the times of the stored samples of a quantity within a time range.
+ *
+ * in:  quantity  Quantity of the samples.
+ *      from      Start of the range (msec since epoch).
+ *      to        End of the range, inclusive (msec since epoch).
+ * out: times     Times of the samples (msec since epoch) are added.
+ *      return    False if the samples could not be read.
+ */
+{
+    QSqlQuery query;
+
+    if(!this->database_opened)
+        return false;
+
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT datetime FROM %1 WHERE datetime BETWEEN ? AND ?").arg(quantity_tables[quantity]));
+    query.addBindValue(QDateTime::fromMSecsSinceEpoch(from));
+    query.addBindValue(QDateTime::fromMSecsSinceEpoch(to));
+
+    if(!query.exec())
+    {
+        qWarning() << "Unable to read sample times:" << query.lastError().text();
+        return false;
+    }
+
+    while(query.next())
+        times->insert(query.value(0).toDateTime().toMSecsSinceEpoch());
+
+    return true;
+}
+
+bool WeatherDatabase::ReadSamples(WeatherQuantity quantity, qint64 from, qint64 to, QVector<qint64> *times,
+                                  QVector<float> *values)
+/*
+ * Get the samples of a quantity within a time range, ordered by time. The
+ * range is part of the query, so on partitioned tables only the partitions
+ * of the range are read.
+ *
+ * in:  quantity  Quantity of the samples.
+ *      from      Start of the range (msec since epoch).
+ *      to        End of the range, exclusive (msec since epoch).
+ * out: times     Times of the samples (msec since epoch) are appended.
+ *      values    Values of the samples are appended.
+ *      return    False if the samples could not be read.
+ */
+{
+    QSqlQuery query;
+
+    if(!this->database_opened)
+        return false;
+
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT datetime, %1 FROM %2 WHERE datetime >= ? AND datetime < ? ORDER BY datetime")
+                  .arg(quantity_columns[quantity]).arg(quantity_tables[quantity]));
+    query.addBindValue(QDateTime::fromMSecsSinceEpoch(from));
+    query.addBindValue(QDateTime::fromMSecsSinceEpoch(to));
+
+    if(!query.exec())
+    {
+        qWarning() << "Unable to read samples:" << query.lastError().text();
+        return false;
+    }
+
+    while(query.next())
+    {
+        times->append(query.value(0).toDateTime().toMSecsSinceEpoch());
+        values->append(query.value(1).toFloat());
+    }
+
+    return true;
+}
+
+void WeatherDatabase::SetIngestServer(const QString &host, quint16 port, quint32 station)
+/*
+ * Switch to client mode: samples are sent to an ingest server instead of
+ * being stored in the weatherdatabase. Must be called before OpenDatabase().
+ *
+ * in:  host     Host name or address of the ingest server.
+ *      port     UDP port of the ingest server.
+ *      station  Id of this station.
+ * out: none
+ */
+{
+    this->ingest_host = host;
+    this->ingest_port = port;
+    this->station = station;
+
+    // Sequence numbers restart at a different value after a restart, so the
+    // server does not mistake new batches for duplicates of older ones.
+    this->next_sequence = (quint32)QDateTime::currentMSecsSinceEpoch();
+}
+
+void WeatherDatabase::Flush()
+/*
+ * Send the queued samples to the ingest server in batches. Batches that were
+ * not acknowledged since the previous flush are sent again. No-op when not in
+ * client mode.
+ *
+ * in:  none
+ * out: none
+ */
+{
+    if(this->ingest_socket == NULL)
+        return;
+
+    ReadIngestAcks();
+
+    for(int first = 0; first < this->ingest_records.size(); first += INGEST_MAX_RECORDS)
+    {
+        IngestHeader header;
+        QByteArray datagram;
+
+        header.version = INGEST_VERSION;
+        header.type = INGEST_TYPE_BATCH;
+        header.station = this->station;
+        header.sequence = this->next_sequence++;
+        header.count = qMin(INGEST_MAX_RECORDS, this->ingest_records.size() - first);
+
+        datagram.resize(INGEST_HEADER_SIZE + header.count * INGEST_RECORD_SIZE);
+        uint8_t *p = (uint8_t *)datagram.data();
+
+        ingest_encode_header(p, header);
+        for(int i = 0; i < header.count; i++)
+            ingest_encode_record(p + INGEST_HEADER_SIZE + i * INGEST_RECORD_SIZE, this->ingest_records[first + i]);
+
+        this->unacked_batches.insert(header.sequence, datagram);
+    }
+    this->ingest_records.clear();
+
+    // Keep the memory bounded when the server is unreachable for a long time.
+    while(this->unacked_batches.size() > INGEST_MAX_UNACKED)
+    {
+        qWarning() << "Ingest server unreachable, dropping batch" << this->unacked_batches.firstKey();
+        this->unacked_batches.erase(this->unacked_batches.begin());
+    }
+
+    foreach(const QByteArray &datagram, this->unacked_batches)
+        this->ingest_socket->writeDatagram(datagram, this->ingest_address, this->ingest_port);
+}
+
+void WeatherDatabase::QueueIngestRecord(WeatherQuantity quantity, float value, const QDateTime &datetime)
+/*
+ * Queue a sample for the next batch to the ingest server.
+ */
+{
+    IngestRecord record;
+
+    record.time = datetime.toMSecsSinceEpoch();
+    record.value = value;
+    record.quantity = quantity;
+
+    this->ingest_records.append(record);
+}
+
+void WeatherDatabase::ReadIngestAcks()
+/*
+ * Process the acknowledgements received from the ingest server. The socket is
+ * read without blocking, acknowledgements are simply collected at the next
+ * flush.
+ */
+{
+    uint8_t buffer[INGEST_MAX_DATAGRAM];
+    IngestHeader header;
+
+    while(this->ingest_socket->hasPendingDatagrams())
+    {
+        int size = this->ingest_socket->readDatagram((char *)buffer, sizeof(buffer));
+
+        if(ingest_decode_header(buffer, size, &header) &&
+           header.type == INGEST_TYPE_ACK && header.station == this->station)
+            this->unacked_batches.remove(header.sequence);
     }
 }
 
@@ -177,10 +637,76 @@ void WeatherDatabase::PurgeDatabase()
         if(ok)
         {
             // Recreate required tables.
-            query.exec("CREATE TABLE IF NOT EXISTS temperaturedata (datetime DATETIME, temperature FLOAT)");
-            query.exec("CREATE TABLE IF NOT EXISTS humiditydata (datetime DATETIME, humidity FLOAT)");
-            query.exec("CREATE TABLE IF NOT EXISTS airpressuredata (datetime DATETIME, airpressure FLOAT)");
-            query.exec("CREATE TABLE IF NOT EXISTS imagedata (id SMALLINT, image LONGBLOB, PRIMARY KEY (id))");
+            CreateTables();
         }
     }
 }
+
+bool WeatherDatabase::ReadTableRange(const char *table, qint64 *first, qint64 *last)
+/*
+ * Get the time range of the rows of a table.
+ *
+ * in:  table   Table with a datetime column.
+ * out: first   Oldest time (msec since epoch), LLONG_MAX if the table is empty.
+ *      last    Newest time (msec since epoch), LLONG_MIN if the table is empty.
+ *      return  False if the table could not be read.
+ */
+{
+    QSqlQuery query;
+
+    *first = LLONG_MAX;
+    *last = LLONG_MIN;
+
+    if(!this->database_opened)
+        return false;
+
+    if(!query.exec(QString("SELECT MIN(datetime), MAX(datetime) FROM %1").arg(table)) || !query.next())
+    {
+        qWarning() << "Unable to read the range of" << table << ":" << query.lastError().text();
+        return false;
+    }
+
+    // MIN() of an empty table is NULL.
+    if(!query.value(0).isNull())
+    {
+        *first = query.value(0).toDateTime().toMSecsSinceEpoch();
+        *last = query.value(1).toDateTime().toMSecsSinceEpoch();
+    }
+
+    return true;
+}
+
+void WeatherDatabase::CreateTables()
+/*
+ * Create the required tables if these do not exist. The raw data tables are
+ * partitioned by the retention manager once it runs, the hourly tables hold
+ * the rollups of the raw data that has expired.
+ *
+ * in:  none
+ * out: none
+ */
+{
+    QSqlQuery query;
+
+    query.exec("CREATE TABLE IF NOT EXISTS temperaturedata (datetime DATETIME, temperature FLOAT)");
+    query.exec("CREATE TABLE IF NOT EXISTS humiditydata (datetime DATETIME, humidity FLOAT)");
+    query.exec("CREATE TABLE IF NOT EXISTS airpressuredata (datetime DATETIME, airpressure FLOAT)");
+    query.exec("CREATE TABLE IF NOT EXISTS imagedata (id SMALLINT, image LONGBLOB, PRIMARY KEY (id))");
+    query.exec("CREATE TABLE IF NOT EXISTS imageframes (hash CHAR(40), image LONGBLOB, PRIMARY KEY (hash))");
+    query.exec("CREATE TABLE IF NOT EXISTS imageindex (datetime DATETIME, hash CHAR(40))");
+    // Used to find the frames no longer referenced once the index expires,
+    // fails harmlessly when the index exists.
+    query.exec("CREATE INDEX imageindex_hash ON imageindex (hash)");
+    query.exec("CREATE TABLE IF NOT EXISTS stationdata "
+               "(station INT UNSIGNED, datetime DATETIME, quantity TINYINT, value FLOAT)");
+
+    query.exec("CREATE TABLE IF NOT EXISTS temperaturedata_hourly "
+               "(datetime DATETIME, minimum FLOAT, average FLOAT, maximum FLOAT, samples INT, PRIMARY KEY (datetime))");
+    query.exec("CREATE TABLE IF NOT EXISTS humiditydata_hourly "
+               "(datetime DATETIME, minimum FLOAT, average FLOAT, maximum FLOAT, samples INT, PRIMARY KEY (datetime))");
+    query.exec("CREATE TABLE IF NOT EXISTS airpressuredata_hourly "
+               "(datetime DATETIME, minimum FLOAT, average FLOAT, maximum FLOAT, samples INT, PRIMARY KEY (datetime))");
+    query.exec("CREATE TABLE IF NOT EXISTS stationdata_hourly "
+               "(station INT UNSIGNED, datetime DATETIME, quantity TINYINT, "
+               "minimum FLOAT, average FLOAT, maximum FLOAT, samples INT, PRIMARY KEY (station, quantity, datetime))");
+}
@@ -6,6 +6,8 @@
  * Date:        24-01-2014
  * Description: This class offers functionality add the temperature, humidity
  *              and air pressure to the mysql database.
+ *              In client mode the samples are sent to an ingest server in
+ *              batches instead (see ingestprotocol.h).
  */
 
 #include <QSqlDatabase>
@@ -13,25 +15,79 @@
 #include <QVariant>
 #include <QDebug>
 #include <QFile>
+#include <QDateTime>
+#include <QVector>
+#include <QMap>
+#include <QSet>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <ingestprotocol.h>
+
+enum WeatherQuantity
+{
+    QUANTITY_TEMPERATURE,
+    QUANTITY_HUMIDITY,
+    QUANTITY_AIRPRESSURE,
+    QUANTITY_COUNT
+};
+
+#define INGEST_MAX_UNACKED  (1024)   // batches kept for resending, about 17 hours at one batch per minute
+#define INSERT_BATCH_ROWS   (500)    // rows per multi-row insert statement
+#define SQLITE_MAX_PARAMS   (999)    // parameters per statement on SQLite
+
+struct StationSample
+{
+    quint32 station;
+    qint64 time;        // msec since epoch
+    quint8 quantity;    // WeatherQuantity
+    float value;
+};
 
 class WeatherDatabase
 {
 public:
     WeatherDatabase();
+    WeatherDatabase(const QString &driver, const QString &databasename);
 
-    void OpenDatabase();
+    bool OpenDatabase();
     void CloseDatabase();
 
-    void AddTemperatureData(float temperature);
-    void AddHumidityData(float humidity);
-    void AddAirpressureData(float airpressure);
-    void AddImageData(char* imagepath);
+    void AddTemperatureData(float temperature, const QDateTime &datetime = QDateTime::currentDateTime());
+    void AddHumidityData(float humidity, const QDateTime &datetime = QDateTime::currentDateTime());
+    void AddAirpressureData(float airpressure, const QDateTime &datetime = QDateTime::currentDateTime());
+    void AddData(WeatherQuantity quantity, float value, const QDateTime &datetime);
+    bool AddImageData(const QByteArray &image, const QByteArray &hash, const QDateTime &datetime);
+
+    bool AddStationData(const QVector<StationSample> &samples);
+    bool AddBulkData(const QVector<StationSample> &samples);
+    bool ReadSampleRange(WeatherQuantity quantity, qint64 *first, qint64 *last);
+    bool ReadRollupRange(WeatherQuantity quantity, qint64 *first, qint64 *last);
+    bool ReadSampleTimes(WeatherQuantity quantity, qint64 from, qint64 to, QSet<qint64> *times);
+    bool ReadSamples(WeatherQuantity quantity, qint64 from, qint64 to, QVector<qint64> *times, QVector<float> *values);
+
+    void SetIngestServer(const QString &host, quint16 port, quint32 station);
+    void Flush();
 
     void PurgeDatabase();
 
 private:
+    void CreateTables();
+    bool ReadTableRange(const char *table, qint64 *first, qint64 *last);
+    void QueueIngestRecord(WeatherQuantity quantity, float value, const QDateTime &datetime);
+    void ReadIngestAcks();
+
     QSqlDatabase db;
     bool database_opened;
+
+    // Client mode, samples are sent to an ingest server instead of the database.
+    QUdpSocket *ingest_socket;
+    QString ingest_host;
+    QHostAddress ingest_address;
+    quint16 ingest_port;
+    quint32 station;
+    quint32 next_sequence;
+    QVector<IngestRecord> ingest_records;
+    QMap<quint32, QByteArray> unacked_batches;
 };
 
 #endif // WEATHERDATABASE_H
@@ -0,0 +1,92 @@
+/*
+ * Date:        19-10-2026
+ * Description: This class publishes the latest readings of the weatherstation
+ *              in a POSIX shared memory segment, so local consumers can read
+ *              them without querying the database (see weatherreader.h).
+ */
+
+#include "weatherpublisher.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+WeatherPublisher::WeatherPublisher()
+/*
+ * Constructor.
+ *
+ * in:  none
+ * out: none
+ */
+{
+    this->shm = NULL;
+}
+
+bool WeatherPublisher::Open(const char *name)
+/*
+ * Create (or reuse) and map the shared memory segment. The segment is
+ * readable by everyone and only writable by the weatherstation.
+ *
+ * in:  name   Name of the shared memory segment.
+ * out: return False if the segment could not be created.
+ */
+{
+    int fd;
+    void *address;
+
+    Close();
+
+    fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if(fd == -1)
+        return false;
+
+    if(ftruncate(fd, sizeof(WeatherSharedMemory)) == -1)
+    {
+        close(fd);
+        return false;
+    }
+
+    address = mmap(NULL, sizeof(WeatherSharedMemory), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(address == MAP_FAILED)
+        return false;
+
+    // Start from an empty reading with an even sequence. Readers that still
+    // map the segment of a previous run only see a consistent snapshot.
+    this->shm = (WeatherSharedMemory *)address;
+    this->shm->sequence.store(0, std::memory_order_relaxed);
+    for(unsigned int i = 0; i < WEATHER_READING_WORDS; i++)
+        this->shm->words[i].store(0, std::memory_order_relaxed);
+    this->shm->magic = WEATHER_SHM_MAGIC;
+    this->shm->version = WEATHER_SHM_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    return true;
+}
+
+void WeatherPublisher::Close()
+/*
+ * Unmap the shared memory segment. The segment itself is kept, so readers
+ * can still see the last reading.
+ *
+ * in:  none
+ * out: none
+ */
+{
+    if(this->shm != NULL)
+        munmap(this->shm, sizeof(WeatherSharedMemory));
+    this->shm = NULL;
+}
+
+void WeatherPublisher::Publish(const WeatherReading &reading)
+/*
+ * Publish a new reading.
+ *
+ * in:  reading Latest reading.
+ * out: none
+ */
+{
+    if(this->shm != NULL)
+        weather_shm_write(this->shm, &reading);
+}
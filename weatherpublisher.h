@@ -0,0 +1,26 @@
+#ifndef WEATHERPUBLISHER_H
+#define WEATHERPUBLISHER_H
+
+/*
+ * Date:        19-10-2026
+ * Description: This class publishes the latest readings of the weatherstation
+ *              in a POSIX shared memory segment, so local consumers can read
+ *              them without querying the database (see weatherreader.h).
+ */
+
+#include <weathersharedmemory.h>
+
+class WeatherPublisher
+{
+public:
+    WeatherPublisher();
+
+    bool Open(const char *name = WEATHER_SHM_NAME);
+    void Close();
+    void Publish(const WeatherReading &reading);
+
+private:
+    WeatherSharedMemory *shm;
+};
+
+#endif // WEATHERPUBLISHER_H
@@ -0,0 +1,122 @@
+#ifndef WEATHERREADER_H
+#define WEATHERREADER_H
+
+/*
+ * Date:        19-10-2026
+ * Description: Header only library for local consumers (dashboards, alerting
+ *              scripts) to read the latest weatherstation readings from
+ *              shared memory. Opening maps the segment read-only, after that
+ *              each Read() is lock-free and free of system calls.
+ *
+ *              Example:
+ *                  WeatherReader reader;
+ *                  WeatherReading reading;
+ *                  if(reader.Open() && reader.Read(&reading))
+ *                      printf("%.1f\n", reading.temperature);
+ *
+ *              Link with -lrt.
+ */
+
+#include <weathersharedmemory.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+class WeatherReader
+{
+public:
+    WeatherReader()
+    /*
+     * Constructor.
+     */
+    {
+        this->shm = NULL;
+    }
+
+    ~WeatherReader()
+    /*
+     * Destructor. Unmaps the segment.
+     */
+    {
+        Close();
+    }
+
+    bool Open(const char *name = WEATHER_SHM_NAME)
+    /*
+     * Map the shared memory segment published by the weatherstation.
+     *
+     * in:  name   Name of the shared memory segment.
+     * out: return False if the segment does not exist or has another layout.
+     */
+    {
+        struct stat st;
+        int fd;
+        void *address;
+
+        Close();
+
+        fd = shm_open(name, O_RDONLY, 0);
+        if(fd == -1)
+            return false;
+
+        if(fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(WeatherSharedMemory))
+        {
+            close(fd);
+            return false;
+        }
+
+        address = mmap(NULL, sizeof(WeatherSharedMemory), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if(address == MAP_FAILED)
+            return false;
+
+        this->shm = (const WeatherSharedMemory *)address;
+
+        if(this->shm->magic != WEATHER_SHM_MAGIC || this->shm->version != WEATHER_SHM_VERSION)
+        {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close()
+    /*
+     * Unmap the shared memory segment.
+     */
+    {
+        if(this->shm != NULL)
+            munmap((void *)this->shm, sizeof(WeatherSharedMemory));
+        this->shm = NULL;
+    }
+
+    bool Read(WeatherReading *reading, int max_attempts = 1000) const
+    /*
+     * Copy a consistent snapshot of the latest reading.
+     *
+     * in:  max_attempts Number of attempts before giving up.
+     * out: reading      Latest reading.
+     *      return       False if no consistent snapshot could be taken or
+     *                   nothing has been published yet.
+     */
+    {
+        if(this->shm == NULL)
+            return false;
+
+        for(int i = 0; i < max_attempts; i++)
+        {
+            if(weather_shm_try_read(this->shm, reading))
+                return reading->count > 0;
+        }
+
+        return false;
+    }
+
+private:
+    const WeatherSharedMemory *shm;
+};
+
+#endif // WEATHERREADER_H
@@ -0,0 +1,107 @@
+#ifndef WEATHERSHAREDMEMORY_H
+#define WEATHERSHAREDMEMORY_H
+
+/*
+ * Date:        19-10-2026
+ * Description: Layout of the POSIX shared memory segment in which the
+ *              weatherstation publishes its latest readings. The segment is
+ *              protected by a seqlock: the single writer makes the sequence
+ *              odd while it updates the reading, readers retry until they
+ *              copied the reading under an unchanged, even sequence.
+ *              Readers never block the writer and need no system calls.
+ *
+ *              This header has no dependencies on Qt, so local consumers can
+ *              use it directly (see weatherreader.h).
+ */
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+#define WEATHER_SHM_NAME        "/weatherstation"
+#define WEATHER_SHM_MAGIC       (0x57535431)    // "WST1"
+#define WEATHER_SHM_VERSION     (1)
+
+// Status flags of a reading
+#define WEATHER_STATUS_DHT22_VALID   (1 << 0)
+#define WEATHER_STATUS_BMP085_VALID  (1 << 1)
+#define WEATHER_STATUS_IMAGE_VALID   (1 << 2)
+
+struct WeatherReading
+{
+    int64_t time;               // msec since epoch of the acquisition
+    int64_t dht22_time;         // msec since epoch of the last valid DHT22 reading
+    int64_t bmp085_time;        // msec since epoch of the last valid BMP085 reading
+    int64_t image_time;         // msec since epoch of the last picture
+    uint64_t count;             // number of acquisitions since start
+    float temperature;          // degrees celcius
+    float humidity;             // relative (%)
+    float airpressure;          // hPa
+    uint32_t status;            // WEATHER_STATUS_* flags
+};
+
+#define WEATHER_READING_WORDS ((sizeof(WeatherReading) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+struct WeatherSharedMemory
+{
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence;
+
+    // The reading is copied word by word with relaxed atomics, 32 bit atomics
+    // are lock-free (and thus usable in shared memory) on every Raspberry Pi.
+    std::atomic<uint32_t> words[WEATHER_READING_WORDS];
+};
+
+static inline void weather_shm_write(WeatherSharedMemory *shm, const WeatherReading *reading)
+/*
+ * Publish a reading. Must only be called by a single writer.
+ *
+ * in:  shm     Mapped shared memory segment.
+ *      reading Reading to publish.
+ * out: none
+ */
+{
+    uint32_t words[WEATHER_READING_WORDS] = { 0 };
+    uint32_t sequence = shm->sequence.load(std::memory_order_relaxed);
+
+    memcpy(words, reading, sizeof(WeatherReading));
+
+    shm->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for(unsigned int i = 0; i < WEATHER_READING_WORDS; i++)
+        shm->words[i].store(words[i], std::memory_order_relaxed);
+
+    shm->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+static inline bool weather_shm_try_read(const WeatherSharedMemory *shm, WeatherReading *reading)
+/*
+ * Take a single attempt at copying a consistent reading.
+ *
+ * in:  shm     Mapped shared memory segment.
+ * out: reading Copy of the published reading.
+ *      return  False if the writer interfered and the copy must be retried.
+ */
+{
+    uint32_t words[WEATHER_READING_WORDS];
+    uint32_t sequence1 = shm->sequence.load(std::memory_order_acquire);
+
+    if(sequence1 & 1)
+        return false;
+
+    for(unsigned int i = 0; i < WEATHER_READING_WORDS; i++)
+        words[i] = shm->words[i].load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if(shm->sequence.load(std::memory_order_relaxed) != sequence1)
+        return false;
+
+    memcpy(reading, words, sizeof(WeatherReading));
+
+    return true;
+}
+
+#endif // WEATHERSHAREDMEMORY_H
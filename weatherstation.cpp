@@ -1,13 +1,69 @@
 #include "weatherstation.h"
+#include <QJsonDocument>
 
-WeatherStation::WeatherStation(bool purge_database, bool debugmode)
+WeatherStation::WeatherStation(bool purge_database, bool debugmode, int raw_retention, int rollup_retention)
 {
     this->bmp085sensor = NULL;
     this->dht22sensor = NULL;
     this->weatherdatabase = NULL;
+    this->retentionmanager = NULL;
+    this->imagestore = NULL;
+    this->imagepipeline = NULL;
+    this->weatherpublisher = NULL;
+    this->streamanalytics = NULL;
+    this->httpserver = NULL;
+    this->httpthread = NULL;
+    this->http_address = HTTP_ADDRESS;
+    this->http_port = HTTP_PORT;
+    this->ingest_port = INGEST_PORT;
+    this->station = 0;
+
+    memset(&this->reading, 0, sizeof(this->reading));
 
     this->purge_database = purge_database;
     this->debugmode = debugmode;
+    this->raw_retention = raw_retention;
+    this->rollup_retention = rollup_retention;
+
+    this->tolerance[QUANTITY_TEMPERATURE] = TEMPERATURE_TOLERANCE;
+    this->tolerance[QUANTITY_HUMIDITY] = HUMIDITY_TOLERANCE;
+    this->tolerance[QUANTITY_AIRPRESSURE] = AIRPRESSURE_TOLERANCE;
+
+    for(int i = 0; i < QUANTITY_COUNT; i++)
+        this->swingingdoor[i] = NULL;
+}
+
+void WeatherStation::set_deadband(float temperature_tolerance, float humidity_tolerance, float airpressure_tolerance)
+/*
+ * Set the tolerance per quantity for the stored data. A tolerance of 0
+ * stores every sample that is not exactly on the linear trend.
+ */
+{
+    this->tolerance[QUANTITY_TEMPERATURE] = temperature_tolerance;
+    this->tolerance[QUANTITY_HUMIDITY] = humidity_tolerance;
+    this->tolerance[QUANTITY_AIRPRESSURE] = airpressure_tolerance;
+}
+
+void WeatherStation::set_http_interface(const QString &address, int port)
+/*
+ * Set the address and TCP port of the HTTP interface, 0 disables the
+ * interface. The interface is not authenticated, only listen on other
+ * addresses than the loopback in a trusted network.
+ */
+{
+    this->http_address = address;
+    this->http_port = port;
+}
+
+void WeatherStation::set_ingest_server(const QString &host, quint16 port, quint32 station)
+/*
+ * Send the samples to an ingest server instead of storing them in the
+ * database directly.
+ */
+{
+    this->ingest_host = host;
+    this->ingest_port = port;
+    this->station = station;
 }
 
 void WeatherStation::start_acquisition()
@@ -19,16 +75,53 @@ void WeatherStation::start_acquisition()
     this->dht22sensor = new DHT22Sensor();
     this->weatherdatabase = new WeatherDatabase();
 
+    for(int i = 0; i < QUANTITY_COUNT; i++)
+        this->swingingdoor[i] = new SwingingDoor(this->tolerance[i], HEARTBEAT_INTERVAL * 1000LL);
+
+    this->imagestore = new ImageStore(this->weatherdatabase);
+    this->imagepipeline = new ImagePipeline(QDir::currentPath());
+    this->streamanalytics = new StreamAnalytics();
+
+    // Publish the latest readings for local consumers.
+    this->weatherpublisher = new WeatherPublisher();
+    if(!this->weatherpublisher->Open())
+        qWarning() << "Unable to publish readings in shared memory";
+
+    // Serve the live data from the event loop of a separate thread, so
+    // clients never delay the acquisition.
+    if(this->http_port > 0)
+    {
+        this->httpthread = new QThread();
+        this->httpserver = new HttpServer(QHostAddress(this->http_address), this->http_port, this->debugmode);
+        this->httpserver->moveToThread(this->httpthread);
+        QObject::connect(this->httpthread, SIGNAL(started()), this->httpserver, SLOT(Start()));
+        this->httpthread->start();
+    }
+
+    if(!this->ingest_host.isEmpty())
+        this->weatherdatabase->SetIngestServer(this->ingest_host, this->ingest_port, this->station);
+
     this->weatherdatabase->OpenDatabase();
 
     if(this->purge_database)
         this->weatherdatabase->PurgeDatabase();
 
+    // Expire old data in the background, so acquisition is never blocked.
+    // In client mode the ingest server expires the data (see ingestmain.cpp).
+    if(this->ingest_host.isEmpty())
+    {
+        this->retentionmanager = new RetentionManager(QSqlDatabase::database(), this->raw_retention,
+                                                      this->rollup_retention, this->debugmode);
+        this->retentionmanager->start(QThread::LowPriority);
+    }
+
     this->bmp085sensor->initsensor();
     this->dht22sensor->InitSensor();
 
     while(success)
     {
+        int64_t time = QDateTime::currentMSecsSinceEpoch();
+
         success = false;
 
         for(int i = 0; i < DHT22_MAX_ATTEMPTS && !success; i++)
@@ -39,15 +132,201 @@ void WeatherStation::start_acquisition()
         // Take picture
         system("raspistill -n -w 320 -h 240 -q 100 -o image.jpg");
 
-        weatherdatabase->AddAirpressureData(airpressure);
-        weatherdatabase->AddHumidityData(humidity);
-        weatherdatabase->AddTemperatureData(temperature);
-        weatherdatabase->AddImageData("image.jpg");
+        QByteArray image = read_image("image.jpg");
+
+        // Publish before storing, the database may be slow or unreachable.
+        publish_reading(time, success, temperature, humidity, airpressure, image);
+        analyze_reading(time, success, temperature, humidity, airpressure);
+
+        store_sample(QUANTITY_AIRPRESSURE, airpressure, time);
+        store_sample(QUANTITY_HUMIDITY, humidity, time);
+        store_sample(QUANTITY_TEMPERATURE, temperature, time);
+        weatherdatabase->Flush();
+        store_image(image, time);
+        imagepipeline->AddFrame(image, time);
 
         sleep(ACQUISITION_INTERVAL);
     }
 
+    flush_samples();
+    imagepipeline->WaitForDone();
+    weatherpublisher->Close();
+
+    if(httpthread != NULL)
+    {
+        httpthread->quit();
+        httpthread->wait();
+    }
+
+    if(retentionmanager != NULL)
+    {
+        retentionmanager->requestInterruption();
+        retentionmanager->wait();
+    }
+
     dht22sensor->CloseSensor();
     weatherdatabase->CloseDatabase();
 }
 
+
+void WeatherStation::store_sample(WeatherQuantity quantity, float value, int64_t time)
+/*
+ * Feed a sample to the swinging door of its quantity and store the samples
+ * that are needed to reconstruct the series within the tolerance.
+ */
+{
+    SwingingDoorSample sample, output[SWINGINGDOOR_MAX_OUTPUT];
+
+    sample.time = time;
+    sample.value = value;
+
+    int count = swingingdoor[quantity]->AddSample(sample, output);
+
+    for(int i = 0; i < count; i++)
+        weatherdatabase->AddData(quantity, output[i].value, QDateTime::fromMSecsSinceEpoch(output[i].time));
+
+    if(this->debugmode)
+        qDebug() << "Quantity" << quantity << "stored" << swingingdoor[quantity]->Emitted()
+                 << "of" << swingingdoor[quantity]->Received() << "samples";
+}
+
+void WeatherStation::flush_samples()
+/*
+ * Store the samples held back by the swinging doors.
+ */
+{
+    SwingingDoorSample output[SWINGINGDOOR_MAX_OUTPUT];
+
+    for(int i = 0; i < QUANTITY_COUNT; i++)
+    {
+        int count = swingingdoor[i]->Flush(output);
+
+        for(int j = 0; j < count; j++)
+            weatherdatabase->AddData((WeatherQuantity)i, output[j].value, QDateTime::fromMSecsSinceEpoch(output[j].time));
+    }
+}
+
+void WeatherStation::publish_reading(int64_t time, bool dht22_valid, float temperature, float humidity,
+                                     float airpressure, const QByteArray &image)
+/*
+ * Publish the latest readings in shared memory and on the HTTP interface.
+ * Values of a sensor that could not be read keep their previous value and
+ * timestamp.
+ */
+{
+    reading.time = time;
+    reading.count++;
+    reading.status = 0;
+
+    if(dht22_valid)
+    {
+        reading.temperature = temperature;
+        reading.humidity = humidity;
+        reading.dht22_time = time;
+        reading.status |= WEATHER_STATUS_DHT22_VALID;
+    }
+
+    if(bmp085sensor->is_initialized())
+    {
+        reading.airpressure = airpressure;
+        reading.bmp085_time = time;
+        reading.status |= WEATHER_STATUS_BMP085_VALID;
+    }
+
+    if(!image.isEmpty())
+    {
+        reading.image_time = time;
+        reading.status |= WEATHER_STATUS_IMAGE_VALID;
+    }
+
+    weatherpublisher->Publish(reading);
+
+    if(httpserver != NULL)
+        QMetaObject::invokeMethod(httpserver, "PublishReading", Qt::QueuedConnection,
+                                  Q_ARG(WeatherReading, reading), Q_ARG(QByteArray, image));
+}
+
+void WeatherStation::analyze_reading(int64_t time, bool dht22_valid, float temperature, float humidity,
+                                     float airpressure)
+/*
+ * Feed the readings to the stream analytics. The derived signals are
+ * published on the HTTP interface, alerts that are raised or cleared are
+ * reported right away.
+ */
+{
+    quint32 changed = 0;
+
+    if(dht22_valid)
+    {
+        changed |= streamanalytics->AddSample(QUANTITY_TEMPERATURE, time, temperature);
+        changed |= streamanalytics->AddSample(QUANTITY_HUMIDITY, time, humidity);
+    }
+
+    if(bmp085sensor->is_initialized())
+        changed |= streamanalytics->AddSample(QUANTITY_AIRPRESSURE, time, airpressure);
+
+    for(int i = 0; i < StreamAnalytics::ALERT_COUNT; i++)
+    {
+        if(!(changed & (1 << i)))
+            continue;
+
+        QByteArray json = QJsonDocument(streamanalytics->AlertToJson((StreamAnalytics::Alert)i, time))
+                          .toJson(QJsonDocument::Compact);
+
+        qWarning() << "Alert:" << json.constData();
+
+        if(httpserver != NULL)
+            QMetaObject::invokeMethod(httpserver, "PublishAlert", Qt::QueuedConnection, Q_ARG(QByteArray, json));
+    }
+
+    if(httpserver != NULL)
+        QMetaObject::invokeMethod(httpserver, "PublishAnalytics", Qt::QueuedConnection,
+                                  Q_ARG(QByteArray, QJsonDocument(streamanalytics->ToJson(time))
+                                                    .toJson(QJsonDocument::Compact)));
+
+    if(this->debugmode)
+        qDebug() << "Pressure tendency" << streamanalytics->PressureTendency() << "hPa in 3 hours,"
+                 << "temperature" << streamanalytics->Window(QUANTITY_TEMPERATURE, ANALYTICS_WINDOW_1H).Slope()
+                 << "degrees per hour";
+}
+
+QByteArray WeatherStation::read_image(const char *imagepath)
+/*
+ * Read the picture that was taken. The data is shared by the image store
+ * and the image pipeline, so the file is only read once.
+ */
+{
+    QByteArray image;
+    QFile f(imagepath);
+
+    if(f.open(QIODevice::ReadOnly))
+    {
+        image = f.readAll();
+        f.close();
+    }
+
+    return image;
+}
+
+void WeatherStation::store_image(const QByteArray &image, int64_t time)
+/*
+ * Offer the picture that was taken to the image store, which only stores
+ * it when it differs from the last stored picture.
+ */
+{
+    ImageStore::Result result = imagestore->AddImage(image, QDateTime::fromMSecsSinceEpoch(time));
+
+    if(result == ImageStore::IMAGE_FAILED)
+        qWarning() << "Unable to store the image, it is retried with the next picture";
+
+    if(this->debugmode)
+    {
+        qDebug() << "Image" << (result == ImageStore::IMAGE_STORED ? "stored" : "skipped") << ":"
+                 << imagestore->StoredFrames() << "of" << imagestore->Frames() << "frames stored,"
+                 << imagestore->BytesSaved() << "bytes saved,"
+                 << imagestore->ProcessingTime() / imagestore->Frames() << "nsec per frame";
+        qDebug() << "Image pipeline:" << imagepipeline->Frames() << "frames,"
+                 << imagepipeline->AverageProcessingTime() << "nsec per frame,"
+                 << imagepipeline->Utilization() * 100 << "% utilization";
+    }
+}
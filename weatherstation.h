@@ -4,22 +4,66 @@
 #include <bmp085.h>
 #include <dht22sensor.h>
 #include <weatherdatabase.h>
+#include <retentionmanager.h>
+#include <swingingdoor.h>
+#include <imagestore.h>
+#include <imagepipeline.h>
+#include <weatherpublisher.h>
+#include <httpserver.h>
+#include <streamanalytics.h>
+#include <QThread>
+#include <QDir>
 #include <unistd.h>
 #include <errno.h>
 
 #define ACQUISITION_INTERVAL (60) //seconds
 
+// Deadband of the stored data, a sample is only stored when the series
+// departs from the linear trend by more than the tolerance.
+#define TEMPERATURE_TOLERANCE (0.1)   //degrees celcius
+#define HUMIDITY_TOLERANCE    (0.3)   //relative (%)
+#define AIRPRESSURE_TOLERANCE (0.05)  //hPa
+#define HEARTBEAT_INTERVAL    (900)   //seconds
+
 class WeatherStation
 {
 public:
-    WeatherStation(bool purge_database, bool debugmode);
+    WeatherStation(bool purge_database, bool debugmode, int raw_retention, int rollup_retention);
+    void set_deadband(float temperature_tolerance, float humidity_tolerance, float airpressure_tolerance);
+    void set_http_interface(const QString &address, int port);
+    void set_ingest_server(const QString &host, quint16 port, quint32 station);
     void start_acquisition();
 private:
+    void store_sample(WeatherQuantity quantity, float value, int64_t time);
+    void flush_samples();
+    void publish_reading(int64_t time, bool dht22_valid, float temperature, float humidity,
+                         float airpressure, const QByteArray &image);
+    void analyze_reading(int64_t time, bool dht22_valid, float temperature, float humidity, float airpressure);
+    QByteArray read_image(const char *imagepath);
+    void store_image(const QByteArray &image, int64_t time);
+
     BMP085 *bmp085sensor;
     DHT22Sensor *dht22sensor;
     WeatherDatabase *weatherdatabase;
+    RetentionManager *retentionmanager;
+    SwingingDoor *swingingdoor[QUANTITY_COUNT];
+    ImageStore *imagestore;
+    ImagePipeline *imagepipeline;
+    WeatherPublisher *weatherpublisher;
+    WeatherReading reading;
+    StreamAnalytics *streamanalytics;
+    HttpServer *httpserver;
+    QThread *httpthread;
+    QString http_address;
+    int http_port;
+    QString ingest_host;
+    quint16 ingest_port;
+    quint32 station;
+    float tolerance[QUANTITY_COUNT];
     bool purge_database;
     bool debugmode;
+    int raw_retention;
+    int rollup_retention;
 };
 
 #endif // WEATHERSTATION_H
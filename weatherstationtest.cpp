@@ -0,0 +1,364 @@
+/*
+ * Date:        19-10-2026
+ * Description: Unit tests of the weatherstation that run without the sensors
+ *              attached: the sensor decoding, the swinging door compression
+ *              and the sliding window statistics. Build and run them with:
+ *
+ *                  qmake CONFIG+=test && make check
+ */
+
+
+#include <QtTest>
+#include <math.h>
+#include <dht22sensor.h>
+#include <bmp085.h>
+#include <swingingdoor.h>
+#include <slidingwindow.h>
+#include <sensorfixtures.h>
+
+#define SERIES_LENGTH       (7 * 24 * 60)   // a week of samples at one per minute
+#define SAMPLE_INTERVAL     (60000)         // msec
+#define HEARTBEAT_INTERVAL  (900000)        // msec
+#define STORED_ROW_BYTES    (9)             // DATETIME (5 bytes) and FLOAT (4 bytes)
+
+class WeatherStationTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void dht22_decode_data();
+    void dht22_decode();
+    void dht22_decode_invalid();
+    void bmp085_compensate();
+    void swingingdoor_data();
+    void swingingdoor();
+    void swingingdoor_heartbeat();
+    void slidingwindow_data();
+    void slidingwindow();
+    void slidingwindow_empty();
+};
+
+static QVector<float> temperature_series(double noise_amplitude, unsigned int seed)
+/*
+ * A week of temperatures: a daily cycle, weather changes and sensor noise,
+ * quantized to the 0.1 degree resolution of the DHT22.
+ */
+{
+    QVector<float> values(SERIES_LENGTH);
+    double drift = 0;
+
+    for(int i = 0; i < SERIES_LENGTH; i++)
+    {
+        double noise;
+
+        seed = seed * 1103515245 + 12345;
+        noise = ((seed >> 16) % 1000) / 1000.0 - 0.5;
+        drift += noise * 0.01;
+
+        values[i] = roundf((12 + 6 * sin(2 * M_PI * i / (24 * 60)) + drift + noise * noise_amplitude) * 10) / 10;
+    }
+
+    return values;
+}
+
+static QVector<SwingingDoorSample> compress(const QVector<float> &values, float tolerance)
+/*
+ * Feed a series sampled every SAMPLE_INTERVAL to the compressor and collect
+ * the samples it emits.
+ */
+{
+    SwingingDoor door(tolerance, HEARTBEAT_INTERVAL);
+    QVector<SwingingDoorSample> stored;
+    SwingingDoorSample sample, output[SWINGINGDOOR_MAX_OUTPUT];
+    int count;
+
+    for(int i = 0; i < values.size(); i++)
+    {
+        sample.time = (int64_t)i * SAMPLE_INTERVAL;
+        sample.value = values[i];
+
+        count = door.AddSample(sample, output);
+        for(int j = 0; j < count; j++)
+            stored.append(output[j]);
+    }
+
+    count = door.Flush(output);
+    for(int j = 0; j < count; j++)
+        stored.append(output[j]);
+
+    return stored;
+}
+
+static double reconstruction_error(const QVector<float> &values, const QVector<SwingingDoorSample> &stored)
+/*
+ * Largest deviation of the series reconstructed by linear interpolation
+ * between the stored samples.
+ */
+{
+    double max_error = 0;
+
+    for(int i = 0, k = 0; i < values.size(); i++)
+    {
+        int64_t time = (int64_t)i * SAMPLE_INTERVAL;
+        double value;
+
+        while(k + 1 < stored.size() && stored[k + 1].time <= time)
+            k++;
+
+        value = stored[k].value;
+        if(stored[k].time != time)
+            value += (stored[k + 1].value - stored[k].value) * (double)(time - stored[k].time)
+                     / (stored[k + 1].time - stored[k].time);
+
+        max_error = qMax(max_error, fabs(value - values[i]));
+    }
+
+    return max_error;
+}
+
+void WeatherStationTest::dht22_decode_data()
+{
+    QTest::addColumn<float>("temperature");
+    QTest::addColumn<float>("humidity");
+
+    QTest::newRow("room") << 21.3f << 45.2f;
+    QTest::newRow("zero") << 0.0f << 0.0f;
+    QTest::newRow("frost") << -12.7f << 88.8f;
+    QTest::newRow("minimum") << -40.0f << 100.0f;
+    QTest::newRow("maximum") << 80.0f << 99.9f;
+}
+
+void WeatherStationTest::dht22_decode()
+/*
+ * Traces encoded from a reading decode back to the reading.
+ */
+{
+    QFETCH(float, temperature);
+    QFETCH(float, humidity);
+
+    int data[5];
+    float decoded_temperature = -100, decoded_humidity = -100;
+
+    dht22_frame(temperature, humidity, data);
+
+    for(unsigned int seed = 0; seed < 16; seed++)
+    {
+        QVERIFY(DHT22Sensor::DecodePulses(dht22_trace(data, seed), &decoded_temperature, &decoded_humidity));
+        QVERIFY(fabsf(decoded_temperature - temperature) < 0.051f);
+        QVERIFY(fabsf(decoded_humidity - humidity) < 0.051f);
+    }
+}
+
+void WeatherStationTest::dht22_decode_invalid()
+/*
+ * Traces with a wrong checksum or missing bits are rejected.
+ */
+{
+    int data[5] = { 0x01, 0xC5, 0x00, 0xD5, 0x9B };   // 45.3 %, 21.3 degrees
+    float temperature, humidity;
+    QLinkedList<long> trace = dht22_trace(data, 1);
+
+    QVERIFY(DHT22Sensor::DecodePulses(trace, &temperature, &humidity));
+
+    data[4] ^= 0x01;
+    QVERIFY(!DHT22Sensor::DecodePulses(dht22_trace(data, 1), &temperature, &humidity));
+
+    // A short trace of "0" bits would pass the checksum of all zeros.
+    trace.removeLast();
+    QVERIFY(!DHT22Sensor::DecodePulses(trace, &temperature, &humidity));
+
+    QLinkedList<long> zeros;
+    for(int i = 0; i < 12; i++)
+        zeros.append(27000);
+    QVERIFY(!DHT22Sensor::DecodePulses(zeros, &temperature, &humidity));
+    QVERIFY(!DHT22Sensor::DecodePulses(QLinkedList<long>(), &temperature, &humidity));
+}
+
+void WeatherStationTest::bmp085_compensate()
+/*
+ * The example of the datasheet compensates to 699.64 hPa, and a higher raw
+ * pressure gives a higher pressure in every mode.
+ */
+{
+    BMP085 bmp085;
+    float pressure = 0, previous;
+
+    bmp085.load_calibration_data(bmp085_eeprom);
+    bmp085.set_mode(BMP085_ULTRALOWPOWER);
+    bmp085.compensate_pressure(BMP085_EXAMPLE_UT, BMP085_EXAMPLE_UP, &pressure);
+
+    QVERIFY(fabsf(pressure - 699.64f) < 0.005f);
+
+    for(int mode = BMP085_ULTRALOWPOWER; mode <= BMP085_ULTRAHIGHRES; mode++)
+    {
+        bmp085.set_mode(mode);
+        bmp085.compensate_pressure(BMP085_EXAMPLE_UT, BMP085_EXAMPLE_UP << mode, &previous);
+        QVERIFY(fabsf(previous - 699.64f) < 0.5f);
+
+        for(long up = (BMP085_EXAMPLE_UP << mode) + 64; up < (40000L << mode); up += 64 << mode)
+        {
+            bmp085.compensate_pressure(BMP085_EXAMPLE_UT, up, &pressure);
+            QVERIFY(pressure > previous);
+            previous = pressure;
+        }
+    }
+}
+
+void WeatherStationTest::swingingdoor_data()
+{
+    QTest::addColumn<double>("noise");
+    QTest::addColumn<float>("tolerance");
+    QTest::addColumn<double>("min_reduction");
+
+    QTest::newRow("quiet, 0.1") << 0.1 << 0.1f << 5.0;
+    QTest::newRow("quiet, 0.3") << 0.1 << 0.3f << 10.0;
+    QTest::newRow("noisy, 0.1") << 1.0 << 0.1f << 1.0;
+    QTest::newRow("noisy, 0.5") << 1.0 << 0.5f << 2.5;
+}
+
+void WeatherStationTest::swingingdoor()
+/*
+ * The series reconstructed by linear interpolation between the stored
+ * samples stays within the tolerance, while far fewer rows are stored.
+ */
+{
+    QFETCH(double, noise);
+    QFETCH(float, tolerance);
+    QFETCH(double, min_reduction);
+
+    QVector<float> values = temperature_series(noise, 42);
+    QVector<SwingingDoorSample> stored = compress(values, tolerance);
+
+    QVERIFY(stored.size() >= 2);
+    QCOMPARE((qint64)stored.first().time, (qint64)0);
+    QCOMPARE((qint64)stored.last().time, (qint64)(values.size() - 1) * SAMPLE_INTERVAL);
+
+    double max_error = reconstruction_error(values, stored);
+    double reduction = (double)values.size() / stored.size();
+
+    qDebug("rows %d -> %d, bytes %d -> %d, reduction %.1fx, max error %.4f",
+           values.size(), stored.size(), values.size() * STORED_ROW_BYTES,
+           stored.size() * STORED_ROW_BYTES, reduction, max_error);
+
+    QVERIFY(max_error <= tolerance + 1e-4);
+    QVERIFY(reduction >= min_reduction);
+}
+
+void WeatherStationTest::swingingdoor_heartbeat()
+/*
+ * A constant series is stored at least once per heartbeat interval, and a
+ * tolerance of 0 stores every change.
+ */
+{
+    QVector<float> constant(SERIES_LENGTH, 15.0f);
+    QVector<SwingingDoorSample> stored = compress(constant, 0.1f);
+
+    for(int i = 1; i < stored.size(); i++)
+        QVERIFY(stored[i].time - stored[i - 1].time <= HEARTBEAT_INTERVAL);
+    QVERIFY(stored.size() <= (int64_t)SERIES_LENGTH * SAMPLE_INTERVAL / HEARTBEAT_INTERVAL + 2);
+
+    QVector<float> steps(SERIES_LENGTH);
+    for(int i = 0; i < steps.size(); i++)
+        steps[i] = (i / 10) % 2 ? 1.0f : 0.0f;
+
+    stored = compress(steps, 0.0f);
+
+    QCOMPARE(reconstruction_error(steps, stored), 0.0);
+}
+
+void WeatherStationTest::slidingwindow_data()
+{
+    QTest::addColumn<qint64>("length");
+
+    QTest::newRow("10 minutes") << (qint64)600000;
+    QTest::newRow("1 hour") << (qint64)3600000;
+    QTest::newRow("3 hours") << (qint64)(3 * 3600000);
+    QTest::newRow("24 hours") << (qint64)(24 * 3600000);
+}
+
+void WeatherStationTest::slidingwindow()
+/*
+ * After every sample of an irregularly sampled series with gaps, all
+ * statistics of the window equal a brute force recomputation over the
+ * samples within the window.
+ */
+{
+    QFETCH(qint64, length);
+
+    SlidingWindow window(length);
+    QVector<int64_t> times;
+    QVector<float> values = temperature_series(1.0, 7);
+    unsigned int seed = 3;
+    int64_t time = 1700000000000LL;
+    int first = 0;
+
+    for(int i = 0; i < values.size(); i++)
+    {
+        // 10 to 110 seconds between samples, now and then an outage of an hour.
+        seed = seed * 1103515245 + 12345;
+        time += 10000 + (seed >> 16) % 100000 + ((seed >> 8) % 500 == 0 ? 3600000 : 0);
+        times.append(time);
+
+        window.AddSample(time, values[i]);
+
+        while(times[first] < time - length)
+            first++;
+
+        double n = i - first + 1, sx = 0, sy = 0, sxx = 0, sxy = 0;
+        float minimum = values[first], maximum = values[first];
+
+        for(int k = first; k <= i; k++)
+        {
+            double x = (times[k] - times[first]) / 3600000.0;
+            sx += x;
+            sy += values[k];
+            sxx += x * x;
+            sxy += x * values[k];
+            minimum = qMin(minimum, values[k]);
+            maximum = qMax(maximum, values[k]);
+        }
+
+        double variance = sxx - sx * sx / n;
+        double slope = (n < 2 || variance <= 0) ? 0 : (sxy - sx * sy / n) / variance;
+
+        QCOMPARE((double)window.Count(), n);
+        QCOMPARE((qint64)window.Span(), (qint64)(times[i] - times[first]));
+        QCOMPARE(window.Minimum(), minimum);
+        QCOMPARE(window.Maximum(), maximum);
+        QCOMPARE(window.Change(), values[i] - values[first]);
+        QVERIFY(fabs(window.Mean() - sy / n) < 1e-5);
+        QVERIFY(fabs(window.Slope() - slope) < 1e-5 * qMax(1.0, fabs(slope)));
+    }
+}
+
+void WeatherStationTest::slidingwindow_empty()
+/*
+ * An empty window and a window with a single sample have defined results.
+ */
+{
+    SlidingWindow window(3600000);
+
+    QCOMPARE((int)window.Count(), 0);
+    QCOMPARE(window.Mean(), 0.0);
+    QCOMPARE(window.Slope(), 0.0);
+    QCOMPARE(window.Change(), 0.0f);
+
+    window.AddSample(0, 1013.25f);
+
+    QCOMPARE((int)window.Count(), 1);
+    QCOMPARE(window.Mean(), (double)1013.25f);
+    QCOMPARE(window.Minimum(), 1013.25f);
+    QCOMPARE(window.Maximum(), 1013.25f);
+    QCOMPARE(window.Slope(), 0.0);
+
+    // A sample far in the future expires all others.
+    window.AddSample(24 * 3600000LL, 990.0f);
+
+    QCOMPARE((int)window.Count(), 1);
+    QCOMPARE(window.Minimum(), 990.0f);
+    QCOMPARE(window.Change(), 0.0f);
+}
+
+QTEST_APPLESS_MAIN(WeatherStationTest)
+
+#include "weatherstationtest.moc"